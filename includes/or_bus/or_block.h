@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_BLOCK_H
+#define	OR_BLOCK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <string.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Number of areas for block transfer
+    #define BLOCK_AREAS 4
+    // Area not selected
+    #define BLOCK_NONE BLOCK_AREAS
+
+    /// function to read data of an area (offset, buffer, length), false on error
+    typedef bool (*block_read_t)(uint32_t, unsigned char*, unsigned int);
+    /// function to write data of an area (offset, data, length), false on error
+    typedef bool (*block_write_t)(uint32_t, const unsigned char*, unsigned int);
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Register the message readers for the block transfer (HASHMAP_BLOCK),
+     * call after orb_frame_init. Protocol for a write:
+     * 1. (D) BLOCK_STATE with area, size of the transfer and offset to start,
+     *    lower or equal to the offset verified (0 for a new transfer)
+     * 2. (D) BLOCK_CHUNK messages in order, back to back in the frames,
+     *    written in the area without reply
+     * 3. (D) BLOCK_CHECK with the CRC16 of the block, the board verifies all
+     *    chunks after the last block and replies BLOCK_STATE: the offset
+     *    verified moves to the end of the block, or stays on the last block
+     *    verified and the host sends the block again.
+     * For a read, the host selects the area with a request (R) of
+     * BLOCK_STATE and requests (R) chunks and check of blocks of the area.
+     * After an interruption, the transfer resumes from the offset verified.
+     */
+    void orb_block_init();
+
+    /**
+     * Register an area for block transfer (firmware, calibration table, log
+     * buffer, ...). The data of a write are written before the check: the
+     * data after the offset verified are not valid.
+     * @param area number of the area, lower than BLOCK_AREAS
+     * @param size size of the area
+     * @param read function to read the area, NULL for a write only area
+     * @param write function to write the area, NULL for a read only area
+     * @return false if the number of area is not valid
+     */
+    bool orb_block_area(unsigned char area, uint32_t size, block_read_t read, block_write_t write);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_BLOCK_H */
@@ -23,23 +23,39 @@ extern "C" {
 #endif
 
 #include "packet/packet.h"
+#include "or_bus/or_registry.h"
 #include <stdint.h>          /* For uint16_t definition                       */
 #include <stdbool.h>         /* For true/false definition                     */
 #include <string.h>
+#include <stddef.h>          /* For offsetof definition                       */
     
 /******************************************************************************/
 /* System Level #define Macros                                                */
 /******************************************************************************/
     // Dimension of list messages to decode in a packet
     #define BUFFER_LIST_PARSING 10
+    // Number of replies that can be deferred at the same time
+    #define BUFFER_LIST_DEFERRED 4
+    // Token not valid for a deferred reply
+    #define DEFERRED_INVALID -1
+    // Number of replies in cache
+    #define BUFFER_LIST_CACHE 6
+    // Reply deferred, this message is never sent
+    #define PACKET_DEFERRED 'W'
     /// function to decode packet
     typedef packet_information_t (*frame_reader_t)(unsigned char, unsigned char, unsigned char, message_abstract_u);
+    /// function to decode a single message, registered with set_message_reader
+    typedef packet_information_t (*message_reader_t)(unsigned char, unsigned char, unsigned char, message_abstract_u*);
+    /// function to read a free running timer (cycles, ticks, ...)
+    typedef unsigned int (*parser_clock_t)(void);
     
     #define CREATE_PACKET_DATA(cmd, type, data) createPacket((cmd), PACKET_DATA, (type), &(data), sizeof(data))
     #define CREATE_PACKET_RESPONSE(cmd, type, x) createPacket((cmd), (x), (type), NULL, 0)
     #define CREATE_PACKET_ACK(cmd,type) CREATE_PACKET_RESPONSE(cmd, type, PACKET_ACK)
     #define CREATE_PACKET_NACK(cmd,type) CREATE_PACKET_RESPONSE(cmd, type, PACKET_NACK)
     #define CREATE_PACKET_EMPTY CREATE_PACKET_RESPONSE(0, 0, PACKET_EMPTY)
+    #define CREATE_PACKET_DEFERRED(cmd,type) CREATE_PACKET_RESPONSE(cmd, type, PACKET_DEFERRED)
+    #define CREATE_PACKET_PATCH(cmd, type, message, field, data) createPatchPacket((cmd), (type), offsetof(message, field), &(data), sizeof(data))
 
 /******************************************************************************/
 /* System Function Prototypes                                                 */
@@ -52,6 +68,93 @@ extern "C" {
 
     void set_frame_reader(unsigned char hash, frame_reader_t send, frame_reader_t receive);
 
+    /**
+     * Add the features of the board (SYSTEM_FEATURE_*) in the capability
+     * sent to the host. The parser replies to the requests of
+     * SYSTEM_CAPABILITY and to the messages of SYSTEM_MODE, without any
+     * reader. A new mode of the link is used after the frame with the ACK,
+     * then the host sends SYSTEM_MODE alone in a packet.
+     * @param features features of the board
+     */
+    void orb_frame_features(unsigned char features);
+
+    /**
+     * Register the readers for a single message of the registry
+     * (packet/frame_registry.h). The parser calls the message readers with
+     * a direct jump from type and command, without the switch on command
+     * in the frame reader. The messages without message readers are sent
+     * to the frame reader of the type. The data in tail is already validated
+     * against the size of the message.
+     * Example: set_message_reader(REGISTRY_MOTOR_VEL_PID, send_pid, receive_pid);
+     * @param index index of the message in registry (REGISTRY_<command>)
+     * @param send reader for requests (R), can be NULL
+     * @param receive reader for data (D), can be NULL
+     */
+    void set_message_reader(int index, message_reader_t send, message_reader_t receive);
+
+    /**
+     * Reserve a deferred reply for a slow message (EEPROM write, I2C read).
+     * A frame reader calls this function, starts the slow operation and
+     * returns CREATE_PACKET_DEFERRED(command, type). The parser goes on with
+     * the other messages and the reply is sent when it is completed with
+     * orb_deferred_complete.
+     * @param type type of the message to reply
+     * @param command command of the message to reply
+     * @return token for the deferred reply or DEFERRED_INVALID if all
+     * BUFFER_LIST_DEFERRED slots are in use (the reader should reply NACK)
+     */
+    int orb_deferred_open(unsigned char type, unsigned char command);
+
+    /**
+     * Complete a deferred reply. Can be called from the main loop or from an
+     * interrupt when the slow operation is finished.
+     * @param token token returned from orb_deferred_open
+     * @param reply message to send, CREATE_PACKET_EMPTY release the token
+     * without any reply
+     * @return false if the token is not pending
+     */
+    bool orb_deferred_complete(int token, packet_information_t reply);
+
+    /**
+     * Append all completed deferred replies in a list of messages to send.
+     * The parser call this function after all messages in a packet, the
+     * board can call this function to send the replies in an async packet.
+     * @param list_to_send list of messages to send
+     * @param len number of messages in list_to_send, updated
+     * @param size max number of messages in list_to_send
+     * @return number of replies appended
+     */
+    size_t orb_deferred_flush(packet_information_t* list_to_send, size_t* len, size_t size);
+
+    /**
+     * Append all completed deferred replies back to back in a packet to
+     * send, while there is space in the packet.
+     * @param send_pkg packet to send, length updated
+     * @return number of replies appended
+     */
+    size_t orb_deferred_flush_packet(packet_t* send_pkg);
+
+    /**
+     * Save in cache the reply for a request (R) of a message constant or
+     * slowly changing (SYSTEM_CODE_*, parameters). The first request calls
+     * the send reader, the next requests copy the reply from the cache
+     * until the message is invalidated with orb_cache_invalidate or written
+     * with a (D), (Q) or (P) message.
+     * @param type type of the message
+     * @param command command of the message
+     * @return false if all BUFFER_LIST_CACHE replies are in use
+     */
+    bool orb_cache_register(unsigned char type, unsigned char command);
+
+    /**
+     * Mark the reply in cache as dirty, the next request calls the send
+     * reader. The board calls this function when the message change.
+     * Can be called from an interrupt.
+     * @param type type of the message
+     * @param command command of the message
+     */
+    void orb_cache_invalidate(unsigned char type, unsigned char command);
+
     /**
      * In a packet we have more messages. A typical data packet
      * have this struct:
@@ -65,6 +168,14 @@ extern "C" {
      *      * (R) request data
      *      * (A) ack
      *      * (N) nack
+     * * Message with a patch (P) of a sub-range of a message. The board reads
+     *   the current message, applies the patch and writes back the message.
+     * * Message with data and sequence number (Q), computed as a message with
+     *   data (D). The ACK or NACK reply has in tail the same sequence number.
+     * The data (D) of the messages in registry with a wrong length are
+     * rejected with a NACK before to call any reader.
+     * A reader can defer the reply (see orb_deferred_open), the completed
+     * replies are appended after the replies of this packet.
      * We have tre parts to elaborate and send a new packet (if required)
      * 1. [SAVING] The first part of this function split packets in a
      * list of messages to compute.
@@ -77,6 +188,67 @@ extern "C" {
      */
     bool parser(packet_t* receive_pkg, packet_information_t* list_to_send, size_t* len);
 
+    /**
+     * Load a new packet in the resumable parser. The messages are parsed
+     * with parser_resume.
+     * @param receive_pkg packet to parse, must be valid until the end of
+     * the parsing
+     */
+    void parser_load(packet_t* receive_pkg);
+
+    /**
+     * Parse the messages of the packet loaded with parser_load, until a
+     * budget is exhausted. The next call restarts from the first message not
+     * parsed. At least one message is parsed for each call, if the list
+     * has space for its reply.
+     * Example, parse in the idle slots of the control loop:
+     *      parser_load(&receive);
+     *      while(!parser_resume(list, &len, 0, read_timer, IDLE_BUDGET)) {
+     *          wait_next_idle_slot();
+     *      }
+     * @param list_to_send list of messages to send, filled up to
+     * BUFFER_LIST_PARSING messages
+     * @param len number of messages in list_to_send, updated
+     * @param messages max number of messages to parse, 0 without limit
+     * @param clock timer to measure the budget, NULL without limit
+     * @param budget max time (in clock ticks) for this call
+     * @return true if all messages in the packet are parsed
+     */
+    bool parser_resume(packet_information_t* list_to_send, size_t* len, unsigned int messages, parser_clock_t clock, unsigned int budget);
+
+    /**
+     * Parse a packet and write the replies back to back in the packet to
+     * send, each reply with its real length. The packet to send is ready for
+     * build_pkg without a list of messages and the encoder.
+     * If the packet to send has not space for the largest reply, the parser
+     * stops: send the packet, clear its length and continue with
+     * parser_resume_packet.
+     * Example:
+     *      if(!parser_packet(&receive, &send)) {
+     *          do {
+     *              send_packet(&send);
+     *              send.length = 0;
+     *          } while(!parser_resume_packet(&send, 0, NULL, 0));
+     *      }
+     * @param receive_pkg packet to parse
+     * @param send_pkg packet to send, filled from the first byte
+     * @return true if all messages in the packet are parsed
+     */
+    bool parser_packet(packet_t* receive_pkg, packet_t* send_pkg);
+
+    /**
+     * Parse the messages of the packet loaded with parser_load, as
+     * parser_resume, and append the replies back to back in the packet
+     * to send.
+     * @param send_pkg packet to send, length updated
+     * @param messages max number of messages to parse, 0 without limit
+     * @param clock timer to measure the budget, NULL without limit
+     * @param budget max time (in clock ticks) for this call
+     * @return true if all messages in the packet are parsed, false if a
+     * budget is exhausted or the packet to send is full
+     */
+    bool parser_resume_packet(packet_t* send_pkg, unsigned int messages, parser_clock_t clock, unsigned int budget);
+
     /**
      * Get a list of messages to transform in a packet for serial communication.
      * This function create a new packet and copy with UNION buffer_packet_u and
@@ -117,6 +289,21 @@ extern "C" {
      * @return information_packet ready to send
      */
     inline packet_information_t createDataPacket(unsigned char command, unsigned char type, message_abstract_u * packet, size_t len);
+    /**
+     * Create an information packet to patch (P) a sub-range of a message.
+     * Only the bytes in [offset, offset + len) of the message are sent, the
+     * board applies them over the current value of the message.
+     * Example: CREATE_PACKET_PATCH(cmd, HASHMAP_MOTOR, motor_pid_t, kp, kp)
+     * @param command information about this message
+     * @param type type of command to send
+     * @param offset first byte of the message to write
+     * @param data bytes to write in the message
+     * @param len number of bytes to write (max MAX_BUFF_PATCH)
+     * @return information_packet ready to send, or an empty packet if len is
+     * zero or larger than MAX_BUFF_PATCH, or if the bytes are out of
+     * message_abstract_u (offset + len)
+     */
+    packet_information_t createPatchPacket(unsigned char command, unsigned char type, size_t offset, const void * data, size_t len);
 
 #ifdef	__cplusplus
 }
@@ -23,6 +23,7 @@ extern "C" {
 #endif
 
 #include "packet/packet.h"
+#include <stdbool.h>         /* For true/false definition                     */
 
 /******************************************************************************/
 /* System Level #define Macros                                                */
@@ -43,6 +44,43 @@ extern "C" {
 
 //#define PACKET_EMPTY
 
+    // Integrity modes supported (mask of SYSTEM_INTEGRITY_*), a board on a
+    // link with its check adds SYSTEM_INTEGRITY_NONE (-DMESSAGE_INTEGRITY=7)
+    #ifndef MESSAGE_INTEGRITY
+    #define MESSAGE_INTEGRITY (SYSTEM_INTEGRITY_SUM | SYSTEM_INTEGRITY_CRC16)
+    #endif
+    // Max length of the check in tail of a frame
+    #define LNG_PACKET_INTEGRITY 2
+    // Frames with a wrong check in a row before to go back to the sum
+    #define DECODER_FALLBACK 3
+
+    typedef struct _decoder decoder_t;
+    /// function to decode the next character of a packet
+    typedef int (*decoder_parse_t)(decoder_t* decoder, unsigned char rxchar);
+
+    /**
+     * State to decode the packets of a link:
+     * - function for the next character (header, length or data)
+     * - packet in decoding
+     * - index of the next data in the packet
+     * - counters of the errors (system_error_serial_t), can be NULL
+     * - checksum of the data received
+     * - integrity mode of the link (SYSTEM_INTEGRITY_*)
+     * - frames with a wrong check in a row, after DECODER_FALLBACK frames
+     *   the decoder goes back to SYSTEM_INTEGRITY_SUM: a peer restarted in
+     *   the default mode or a lost ACK of SYSTEM_MODE does not split the
+     *   link
+     */
+    struct _decoder {
+        decoder_parse_t parse;
+        packet_t* packet;
+        unsigned int index;
+        int16_t* error;
+        uint16_t checksum;
+        unsigned char integrity;
+        unsigned char errors;
+    };
+
 /*************************************************************************/
 /* System Function Prototypes                                            */
 /*************************************************************************/
@@ -54,20 +92,123 @@ extern "C" {
     void orb_message_init(packet_t* packet_rx);
 
     /**
-     * Function called on _U1RXInterrupt for decode packet
+     * Integrity mode of the serial port, used from decode_pkgs and
+     * orb_build_pkg.
+     * @return integrity mode (SYSTEM_INTEGRITY_*)
+     */
+    unsigned char orb_message_integrity();
+
+    /**
+     * Enable the negotiation of the integrity mode of the serial port, call
+     * after orb_message_init. Without this call the board sends only
+     * SYSTEM_INTEGRITY_SUM in its capability and the host never changes
+     * the mode. The board must send its frames with orb_build_pkg and the
+     * length returned, build_pkg always builds a frame with the sum.
+     * @param integrity integrity modes allowed (mask of SYSTEM_INTEGRITY_*),
+     * limited to MESSAGE_INTEGRITY
+     */
+    void orb_message_negotiate(unsigned char integrity);
+
+    /**
+     * @return integrity modes allowed on the serial port (mask of
+     * SYSTEM_INTEGRITY_*)
+     */
+    unsigned char orb_message_modes();
+
+    /**
+     * Change the integrity mode of the serial port after the next frame
+     * built with orb_build_pkg, the frame with the ACK of SYSTEM_MODE.
+     * @param integrity integrity mode (SYSTEM_INTEGRITY_*)
+     * @return false if the mode is not allowed (see orb_message_negotiate)
+     */
+    bool orb_message_mode(unsigned char integrity);
+
+    /**
+     * Init a decoder for a link, with the integrity mode
+     * SYSTEM_INTEGRITY_SUM. Each link has its decoder, decode_pkgs and the
+     * pkg_ functions use the decoder of the serial port.
+     * @param decoder decoder to initialize
+     * @param packet_rx packet received
+     * @param error counters of the errors, can be NULL
+     */
+    void orb_decoder_init(decoder_t* decoder, packet_t* packet_rx, int16_t* error);
+
+    /**
+     * Decode a character with the decoder of a link, as decode_pkgs.
+     * @param decoder decoder of the link
+     * @param rxchar character received
+     * @return true when a packet is completed
+     */
+    int orb_decoder_pkgs(decoder_t* decoder, unsigned char rxchar);
+
+    /**
+     * Start value of the check for an integrity mode.
+     * @param integrity integrity mode (SYSTEM_INTEGRITY_*)
+     * @return start value of the check
+     */
+    uint16_t orb_integrity_init(unsigned char integrity);
+
+    /**
+     * Add a buffer in the check, the buffers of a frame can be added one
+     * after the other.
+     * @param integrity integrity mode (SYSTEM_INTEGRITY_*)
+     * @param checksum check of the previous buffers
+     * @param buffer data
+     * @param length length of data
+     * @return check with the buffer
+     */
+    uint16_t orb_integrity_update(unsigned char integrity, uint16_t checksum, const unsigned char* buffer, size_t length);
+
+    /**
+     * Write the check in tail of a frame.
+     * @param integrity integrity mode (SYSTEM_INTEGRITY_*)
+     * @param checksum check of all data
+     * @param tail buffer with space for LNG_PACKET_INTEGRITY bytes
+     * @return number of bytes written
+     */
+    unsigned int orb_integrity_tail(unsigned char integrity, uint16_t checksum, unsigned char* tail);
+
+    /**
+     * Build a frame with the check of an integrity mode.
+     * @param BufferTx buffer with space for MAX_BUFF_TX + LNG_PACKET_HEADER
+     * + LNG_PACKET_INTEGRITY bytes
+     * @param packet packet to send
+     * @param integrity integrity mode (SYSTEM_INTEGRITY_*)
+     * @return length of the frame
+     */
+    unsigned int orb_build_frame(unsigned char* BufferTx, const packet_t* packet, unsigned char integrity);
+
+    /**
+     * Build a frame for the serial port in the integrity mode of the link
+     * and apply the mode requested with orb_message_mode. The length of the
+     * frame changes with the mode: the caller sends the length returned.
+     * @param BufferTx buffer with space for MAX_BUFF_TX + LNG_PACKET_HEADER
+     * + LNG_PACKET_INTEGRITY bytes
+     * @param packet packet to send
+     * @return length of the frame
+     */
+    unsigned int orb_build_pkg(unsigned char* BufferTx, const packet_t* packet);
+
+    /** Decode functions for the header, the length and the data of a
+     *  packet, see pkg_header, pkg_length, pkg_data and pkg_error. */
+    int decoder_header(decoder_t* decoder, unsigned char rxchar);
+    int decoder_length(decoder_t* decoder, unsigned char rxchar);
+    int decoder_data(decoder_t* decoder, unsigned char rxchar);
+    int decoder_error(decoder_t* decoder, int error);
+
+    /**
+     * Build a frame for the serial port, decoded with decode_pkgs
      * Data structure:
      * ------------------------------------------------
      * | HEADER | LENGTH |       DATA           | CKS |
      * ------------------------------------------------
      *     1        2             3 -> n          n+1
      *
-     * Only element of packet have a relative function to decode
-     * 1) Header -> pkg_header
-     * 2) Length -> pkg_length
-     * 3 to n+1) Data -> pkg_data
-     * @param BufferTx buffer to load all bytes
-     * @param rxchar char character received from interrupt
-     * @return boolean result from pointer function called on decode
+     * The frame has always the sum (packet.length + LNG_PACKET_HEADER + 1
+     * bytes), for the negotiation of the mode see orb_build_pkg.
+     * @param BufferTx buffer with space for MAX_BUFF_TX + LNG_PACKET_HEADER
+     * + 1 bytes
+     * @param packet packet to send
      */
     void build_pkg(unsigned char * BufferTx, packet_t packet);
 
@@ -92,8 +233,9 @@ extern "C" {
     int pkg_length(unsigned char rxchar);
 
     /**
-     * Function for decode packet, save in receive_pkg.buffer all bytes. In (n+1)
-     * start pkg_checksum() function to verify correct receive packet.
+     * Function for decode packet, save in receive_pkg.buffer all bytes and
+     * add each byte in the checksum. In (n+1) compare the checksum to verify
+     * correct receive packet, the last byte has a constant time.
      * @param rxchar character received from interrupt
      * @return boolean result. True if don't have any error else start pkg_error
      * and return false.
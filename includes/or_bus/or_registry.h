@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_REGISTRY_H
+#define	OR_REGISTRY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/frame_registry.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <string.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Message not in registry
+    #define REGISTRY_UNKNOWN -1
+    
+    /**
+     * Index of all messages in registry, generated from FRAME_REGISTRY:
+     * REGISTRY_<command> (e.g. REGISTRY_MOTOR_VEL_PID)
+     */
+    #define REGISTRY_INDEX(command, payload, check) REGISTRY_##command,
+    #define REGISTRY_FAMILY_INDEX(type, messages, map) messages(REGISTRY_INDEX)
+    typedef enum {
+        FRAME_REGISTRY(REGISTRY_FAMILY_INDEX)
+        REGISTRY_NUMBER
+    } registry_index_t;
+    #undef REGISTRY_FAMILY_INDEX
+    #undef REGISTRY_INDEX
+
+    /**
+     * Information about a message in registry:
+     * - size of data in tail
+     * - check on length (FRAME_CHECK_EQUAL, FRAME_CHECK_MAX)
+     */
+    typedef struct _registry_length {
+        unsigned char size;
+        unsigned char check;
+    } registry_length_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Find the index of a message in registry. The index is found with two
+     * switch, on type and on command (without motor or port index), that
+     * the compiler converts in jump tables.
+     * @param type type of message
+     * @param command command of message
+     * @return index of message or REGISTRY_UNKNOWN
+     */
+    int orb_registry_index(unsigned char type, unsigned char command);
+
+    /**
+     * @param index index of a message in registry
+     * @return size of data in tail of message
+     */
+    size_t orb_registry_size(int index);
+
+    /**
+     * Verify the length of data in tail of a message.
+     * @param index index of a message in registry
+     * @param length length of data in tail (without header)
+     * @return true if length is valid for the message
+     */
+    bool orb_registry_check(int index, size_t length);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_REGISTRY_H */
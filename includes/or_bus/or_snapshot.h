@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_SNAPSHOT_H
+#define	OR_SNAPSHOT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <string.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Number of attempts to read a consistent copy of a snapshot
+    #define SNAPSHOT_RETRY 4
+    
+    #define SNAPSHOT_INIT(snapshot, data) orb_snapshot_init(&(snapshot), &(data), sizeof(data))
+    #define SNAPSHOT_WRITE(snapshot, data) orb_snapshot_write(&(snapshot), &(data))
+    #define SNAPSHOT_READ(snapshot, data) orb_snapshot_read(&(snapshot), &(data))
+    
+    /**
+     * Message shared between the control loop (writer, in interrupt) and the
+     * frame readers (in the main loop), protected with a sequence lock:
+     * - sequence number, odd when the writer is updating the message
+     * - message (motor_t, motor_diagnostic_t, diff_drive_coordinate_t, ...)
+     * - size of the message
+     * The writer never waits, the reader retries the copy if the writer has
+     * updated the message during the copy.
+     */
+    typedef struct _snapshot {
+        volatile uint16_t sequence;
+        volatile void* data;
+        size_t size;
+    } snapshot_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Associate a snapshot to a message.
+     * @param snapshot snapshot to initialize
+     * @param data message written from the control loop
+     * @param size size of the message
+     */
+    void orb_snapshot_init(snapshot_t* snapshot, volatile void* data, size_t size);
+
+    /**
+     * Start to update the message, called from the writer before change the
+     * message in place.
+     * @param snapshot snapshot of the message
+     */
+    void orb_snapshot_write_begin(snapshot_t* snapshot);
+
+    /**
+     * End the update of the message, called from the writer.
+     * @param snapshot snapshot of the message
+     */
+    void orb_snapshot_write_end(snapshot_t* snapshot);
+
+    /**
+     * Copy a new value in the message.
+     * @param snapshot snapshot of the message
+     * @param value new value of the message
+     */
+    void orb_snapshot_write(snapshot_t* snapshot, const void* value);
+
+    /**
+     * Read a consistent copy of the message. Must not be called from an
+     * interrupt with a priority higher than the writer.
+     * @param snapshot snapshot of the message
+     * @param copy buffer for the copy of the message
+     * @return false if the writer has updated the message for all
+     * SNAPSHOT_RETRY attempts
+     */
+    bool orb_snapshot_read(snapshot_t* snapshot, void* copy);
+
+    /**
+     * Create a data message (D) with a consistent copy of the message,
+     * copied directly in the information packet.
+     * @param snapshot snapshot of the message
+     * @param command command of the message
+     * @param type type of the message
+     * @return information_packet ready to send or a NACK if a consistent
+     * copy is not available
+     */
+    packet_information_t orb_snapshot_packet(snapshot_t* snapshot, unsigned char command, unsigned char type);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_SNAPSHOT_H */
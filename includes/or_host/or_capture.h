@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_CAPTURE_H
+#define	OR_CAPTURE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <stddef.h>
+#include <pthread.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Magic number and version of a capture file
+    #define CAPTURE_MAGIC 0x5043524F /* "ORCP" little endian */
+    #define CAPTURE_VERSION 1
+    // Alignment of the records in the file
+    #define CAPTURE_ALIGN 8
+    #define CAPTURE_PAD(length) (((length) + CAPTURE_ALIGN - 1) & ~(CAPTURE_ALIGN - 1))
+    
+    /** Kind of a record */
+    // Raw bytes received from a link
+    #define CAPTURE_RAW_RX 1
+    // Raw bytes sent on a link
+    #define CAPTURE_RAW_TX 2
+    // Data of a packet decoded (packet_t buffer, without header and checksum)
+    #define CAPTURE_PACKET 3
+    // Integrity mode of a link (one byte, SYSTEM_INTEGRITY_*) for the
+    // bytes of the next records of the link
+    #define CAPTURE_MODE 4
+
+    /**
+     * Header of a capture file:
+     * - magic number and version
+     * - size of this header, the first record starts after it
+     */
+    typedef struct _capture_file {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint32_t reserved[2];
+    } capture_file_t;
+
+    /**
+     * Header of a record, followed by the data and by the padding to
+     * CAPTURE_ALIGN bytes:
+     * - kind of record
+     * - number of the link
+     * - number of bytes of data
+     * - time of the record (ns, CLOCK_REALTIME)
+     */
+    typedef struct _capture_record {
+        uint16_t kind;
+        uint16_t link;
+        uint32_t length;
+        uint64_t time;
+    } capture_record_t;
+
+    /**
+     * Capture in writing, append only, can be shared between threads:
+     * - file descriptor
+     * - lock for the writes
+     */
+    typedef struct _capture {
+        int fd;
+        pthread_mutex_t lock;
+    } capture_t;
+
+    /**
+     * Capture mapped in memory for the readers:
+     * - first byte of the file
+     * - size of the file
+     */
+    typedef struct _capture_map {
+        const unsigned char* data;
+        size_t size;
+    } capture_map_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Open a capture file to append records, with the header if the file is
+     * new.
+     * @param capture capture to open
+     * @param path path of the file
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_capture_open(capture_t* capture, const char* path);
+
+    /**
+     * Close a capture file.
+     * @param capture capture to close
+     */
+    void orb_capture_close(capture_t* capture);
+
+    /**
+     * @return current time for a record (ns, CLOCK_REALTIME)
+     */
+    uint64_t orb_capture_time(void);
+
+    /**
+     * Append a record with a single write.
+     * @param capture capture in writing
+     * @param kind kind of record
+     * @param link number of the link
+     * @param data data of the record
+     * @param length number of bytes of data
+     * @param time time of the record
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_capture_write(capture_t* capture, uint16_t kind, uint16_t link, const void* data, uint32_t length, uint64_t time);
+
+    /**
+     * Append a packet decoded as a CAPTURE_PACKET record.
+     * @param capture capture in writing
+     * @param link number of the link
+     * @param packet packet decoded
+     * @param time time of the record
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_capture_packet(capture_t* capture, uint16_t link, packet_t* packet, uint64_t time);
+
+    /**
+     * Append a change of the integrity mode of a link as a CAPTURE_MODE
+     * record. A replay decodes the next raw bytes of the link in this mode.
+     * @param capture capture in writing
+     * @param link number of the link
+     * @param integrity new integrity mode (SYSTEM_INTEGRITY_*)
+     * @param time time of the record
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_capture_mode(capture_t* capture, uint16_t link, unsigned char integrity, uint64_t time);
+
+    /**
+     * Map a capture file in memory, read only.
+     * @param map capture to map
+     * @param path path of the file
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_capture_map(capture_map_t* map, const char* path);
+
+    /**
+     * Unmap a capture file.
+     * @param map capture mapped
+     */
+    void orb_capture_unmap(capture_map_t* map);
+
+    /**
+     * Read the record at an offset and move the offset on the next record.
+     * Example:
+     *      size_t offset = 0;
+     *      const capture_record_t* record;
+     *      while((record = orb_capture_next(&map, &offset)) != NULL) {
+     *          const unsigned char* data = (const unsigned char*) (record + 1);
+     *      }
+     * @param map capture mapped
+     * @param offset offset of the record, 0 for the first record
+     * @return the record or NULL at the end of the file or on a truncated
+     * record
+     */
+    const capture_record_t* orb_capture_next(const capture_map_t* map, size_t* offset);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_CAPTURE_H */
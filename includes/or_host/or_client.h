@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_CLIENT_H
+#define	OR_CLIENT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <string.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Max number of requests in flight
+    #define CLIENT_SIZE 32
+    
+    /** Result of a request */
+    #define CLIENT_REPLY 0
+    #define CLIENT_NACK 1
+    #define CLIENT_TIMEOUT 2
+    #define CLIENT_UNSOLICITED 3
+    
+    /// function called when a request is completed
+    typedef void (*client_callback_t)(void* data, packet_information_t* message, unsigned char result);
+
+    /**
+     * A request in flight:
+     * - message to send, a request (R) or data (D)
+     * - state of the request
+     * - order of the request, the replies with the same type and command
+     *   complete the requests in order
+     * - time of the transmission
+     * - function (and data) called when the request is completed
+     */
+    typedef struct _client_entry {
+        packet_information_t message;
+        unsigned char state;
+        unsigned int order;
+        unsigned int time;
+        client_callback_t callback;
+        void* data;
+    } client_entry_t;
+
+    /**
+     * Client with many requests in flight on a link:
+     * - requests in flight
+     * - order of the next request
+     * - time before a request without reply is completed with CLIENT_TIMEOUT
+     * - function (and data) called for messages without request
+     */
+    typedef struct _client {
+        client_entry_t entry[CLIENT_SIZE];
+        unsigned int order;
+        unsigned int timeout;
+        client_callback_t callback;
+        void* data;
+    } client_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Initialize a client without requests.
+     * @param client client to initialize
+     * @param timeout time without reply before to complete a request
+     * @param callback function called with CLIENT_UNSOLICITED for each
+     * message received without request, can be NULL
+     * @param data pointer passed to the callback
+     */
+    void orb_client_init(client_t* client, unsigned int timeout, client_callback_t callback, void* data);
+
+    /**
+     * Add a request (R) of a message. The request is sent with the next
+     * orb_client_encode.
+     * Example, poll many values in one round trip:
+     *      orb_client_request(&client, HASHMAP_MOTOR, cmd_pid, on_pid, &pid);
+     *      orb_client_request(&client, HASHMAP_MOTOR, cmd_state, on_state, &state);
+     *      packet.length = 0;
+     *      orb_client_encode(&client, &packet, now);
+     *      send(&packet);
+     * @param client client
+     * @param type type of the message
+     * @param command command of the message
+     * @param callback function called with the reply, can be NULL
+     * @param data pointer passed to the callback
+     * @return true if the request is added, false if the client is full
+     */
+    bool orb_client_request(client_t* client, unsigned char type, unsigned char command, client_callback_t callback, void* data);
+
+    /**
+     * Add a message to send, completed with the ACK, NACK or data reply.
+     * @param client client
+     * @param message message to send
+     * @param callback function called with the reply, can be NULL
+     * @param data pointer passed to the callback
+     * @return true if the message is added, false if the client is full
+     */
+    bool orb_client_send(client_t* client, packet_information_t* message, client_callback_t callback, void* data);
+
+    /**
+     * Complete with CLIENT_TIMEOUT the requests sent without reply after the
+     * timeout. Called from orb_client_encode, and from the owner of the
+     * client when there is nothing to send.
+     * @param client client
+     * @param now current time
+     * @return number of requests completed
+     */
+    unsigned int orb_client_expire(client_t* client, unsigned int now);
+
+    /**
+     * Append in a packet the new requests in the order they are added, while
+     * there is space in the packet: the requests of the same type and
+     * command are sent in order and the replies complete them in order. The
+     * requests without reply after the timeout are completed with
+     * CLIENT_TIMEOUT (see orb_client_expire).
+     * @param client client
+     * @param packet packet to send, the messages are appended after length
+     * @param now current time
+     * @return number of messages appended
+     */
+    unsigned int orb_client_encode(client_t* client, packet_t* packet, unsigned int now);
+
+    /**
+     * Complete the oldest request sent with the same type and command of a
+     * reply. The ACK and NACK with sequence number are not replies of the
+     * client (see or_host/or_window.h).
+     * @param client client
+     * @param reply message received
+     * @return true if the reply completes a request
+     */
+    bool orb_client_reply(client_t* client, packet_information_t* reply);
+
+    /**
+     * Complete the requests with all messages in a packet decoded with
+     * decode_pkgs. The messages without request are passed to the callback
+     * of the client.
+     * @param client client
+     * @param packet packet received
+     * @return number of requests completed
+     */
+    unsigned int orb_client_receive(client_t* client, packet_t* packet);
+
+    /**
+     * @param client client
+     * @return number of requests in flight
+     */
+    unsigned int orb_client_pending(client_t* client);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_CLIENT_H */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_COLUMN_H
+#define	OR_COLUMN_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <stddef.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    /** Type of a field in a message */
+    #define COLUMN_INT8 0
+    #define COLUMN_UINT16 1
+    #define COLUMN_INT32 2
+    #define COLUMN_UINT32 3
+    #define COLUMN_FLOAT 4
+
+    /**
+     * A field of a message, a column of the table:
+     * - name of the field
+     * - offset of the field in the message
+     * - type of the field
+     */
+    typedef struct _column_field {
+        const char* name;
+        unsigned char offset;
+        unsigned char type;
+    } column_field_t;
+
+    /** Columns of motor_t and motor_diagnostic_t */
+    #define COLUMN_MOTOR_PWM 0
+    #define COLUMN_MOTOR_EFFORT 1
+    #define COLUMN_MOTOR_CURRENT 2
+    #define COLUMN_MOTOR_VELOCITY 3
+    #define COLUMN_MOTOR_POSITION 4
+    #define COLUMN_MOTOR_POSITION_DELTA 5
+    #define COLUMN_MOTOR_FIELDS 6
+
+    #define COLUMN_DIAGNOSTIC_STATE 0
+    #define COLUMN_DIAGNOSTIC_WATT 1
+    #define COLUMN_DIAGNOSTIC_VOLT 2
+    #define COLUMN_DIAGNOSTIC_TEMPERATURE 3
+    #define COLUMN_DIAGNOSTIC_TIME_CONTROL 4
+    #define COLUMN_DIAGNOSTIC_FIELDS 5
+
+#ifdef HASHMAP_MOTOR
+    extern const column_field_t column_motor[COLUMN_MOTOR_FIELDS];
+    extern const column_field_t column_diagnostic[COLUMN_DIAGNOSTIC_FIELDS];
+#endif
+
+    /**
+     * Table of the last samples of a message, one array for each field:
+     * - fields of the message
+     * - number of fields
+     * - number of samples in each column, power of two
+     * - number of samples appended, the last capacity samples are in the
+     *   table
+     * - columns, capacity floats for each field
+     */
+    typedef struct _column_table {
+        const column_field_t* field;
+        unsigned int fields;
+        size_t capacity;
+        size_t count;
+        float* data;
+    } column_table_t;
+
+    /**
+     * Aggregate of a column:
+     * - number of samples
+     * - min, max and mean value
+     */
+    typedef struct _column_stats {
+        size_t count;
+        float min;
+        float max;
+        float mean;
+    } column_stats_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Allocate a table.
+     * Example:
+     *      orb_column_init(&table, column_motor, COLUMN_MOTOR_FIELDS, 4096);
+     * @param table table to initialize
+     * @param field fields of the message
+     * @param fields number of fields
+     * @param capacity number of samples, power of two
+     * @return false if capacity is not a power of two or without memory
+     */
+    bool orb_column_init(column_table_t* table, const column_field_t* field, unsigned int fields, size_t capacity);
+
+    /**
+     * Release a table.
+     * @param table table to release
+     */
+    void orb_column_free(column_table_t* table);
+
+    /**
+     * Append a sample, each field is converted in float in its column. The
+     * oldest sample is overwritten when the table is full.
+     * @param table table
+     * @param message data of the message (message in packet_information_t)
+     */
+    void orb_column_append(column_table_t* table, const void* message);
+
+    /**
+     * Number of samples in the table.
+     * @param table table
+     * @return min(count, capacity)
+     */
+    size_t orb_column_size(const column_table_t* table);
+
+    /**
+     * Min, max and mean of the last samples of a column.
+     * @param table table
+     * @param field number of the field
+     * @param last number of last samples, 0 for all samples in the table
+     * @param stats aggregate of the column
+     */
+    void orb_column_stats(const column_table_t* table, unsigned int field, size_t last, column_stats_t* stats);
+
+    /**
+     * Percentiles of the last samples of a column.
+     * @param table table
+     * @param field number of the field
+     * @param last number of last samples, 0 for all samples in the table
+     * @param percentile percentiles to compute [0, 100]
+     * @param value value of each percentile
+     * @param number number of percentiles
+     * @return false without samples or without memory
+     */
+    bool orb_column_percentile(const column_table_t* table, unsigned int field, size_t last,
+            const float* percentile, float* value, unsigned int number);
+
+    /**
+     * Kernels on an array of floats, written for the vectorization of the
+     * compiler (-O3).
+     */
+    float orb_column_min(const float* data, size_t length);
+    float orb_column_max(const float* data, size_t length);
+    double orb_column_sum(const float* data, size_t length);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_COLUMN_H */
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_GATEWAY_H
+#define	OR_GATEWAY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include "or_bus/or_message.h"
+#include "or_host/or_capture.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <pthread.h>
+#include <termios.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Max number of links in a gateway
+    #define GATEWAY_LINKS 64
+    // Max number of worker threads
+    #define GATEWAY_WORKERS 16
+    // Bytes read from a link for each read()
+    #define GATEWAY_READ 256
+    // Time (ms) of a worker without events before to check the stop
+    #define GATEWAY_POLL 100
+    // Max time (ms) of a send to wait the space in the output queue
+    #define GATEWAY_SEND 100
+    
+    /// function called from a worker for each packet decoded, with a NULL
+    /// packet when the link is closed (end of file or error)
+    typedef void (*gateway_callback_t)(void* data, int link, packet_t* packet);
+
+    /**
+     * A link of the gateway:
+     * - file descriptor (tty, pseudo-terminal or socket), -1 when closed
+     * - decoder of the link and packet in decoding
+     * - counters of the errors of the decoder
+     * - lock for the writes on the link and for the modes
+     * - integrity mode of the frames sent
+     * - integrity mode for the decoder, applied from the worker before the
+     *   next bytes received (0 without change)
+     */
+    typedef struct _gateway_link {
+        int fd;
+        decoder_t decoder;
+        packet_t packet;
+        system_error_serial_t error;
+        pthread_mutex_t write;
+        unsigned char integrity;
+        unsigned char pending;
+    } gateway_link_t;
+
+    /**
+     * Gateway for many boards. The links are multiplexed with epoll and
+     * decoded from a pool of workers, a link is decoded from one worker at
+     * a time (EPOLLONESHOT) and the packets of a link are delivered in order.
+     * - links
+     * - epoll file descriptor
+     * - workers
+     * - function (and data) called for each packet decoded
+     * - capture of the raw bytes and of the packets of all links, NULL
+     *   without capture
+     */
+    typedef struct _gateway {
+        gateway_link_t link[GATEWAY_LINKS];
+        unsigned int links;
+        int epoll;
+        pthread_t worker[GATEWAY_WORKERS];
+        unsigned int workers;
+        volatile bool running;
+        gateway_callback_t callback;
+        void* data;
+        capture_t* capture;
+    } gateway_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Initialize a gateway without links.
+     * @param gateway gateway to initialize
+     * @param callback function called for each packet decoded, from the
+     * worker threads
+     * @param data pointer passed to the callback
+     * @return 0 or -1 if epoll is not available (see errno)
+     */
+    int orb_gateway_init(gateway_t* gateway, gateway_callback_t callback, void* data);
+
+    /**
+     * Open a tty in raw mode and add it in the gateway. The links are added
+     * before orb_gateway_start.
+     * @param gateway gateway
+     * @param path path of the tty (or of a pseudo-terminal)
+     * @param baud speed of the tty (B115200, ...)
+     * @return number of the link or -1 on error (see errno)
+     */
+    int orb_gateway_open(gateway_t* gateway, const char* path, speed_t baud);
+
+    /**
+     * Add an open file descriptor in the gateway, set in non blocking mode.
+     * @param gateway gateway
+     * @param fd file descriptor of the link
+     * @return number of the link or -1 on error (see errno)
+     */
+    int orb_gateway_add(gateway_t* gateway, int fd);
+
+    /**
+     * Start the workers.
+     * @param gateway gateway
+     * @param workers number of workers, max GATEWAY_WORKERS
+     * @return 0 or -1 if a worker is not started
+     */
+    int orb_gateway_start(gateway_t* gateway, unsigned int workers);
+
+    /**
+     * Send a packet on a link, with header and check in the mode of the
+     * link (see orb_gateway_mode). Can be called from the callback and from
+     * other threads. A full output queue is waited at most GATEWAY_SEND ms
+     * (ETIMEDOUT), a closed link returns EPIPE.
+     * @param gateway gateway
+     * @param link number of the link
+     * @param packet packet to send
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_gateway_send(gateway_t* gateway, int link, packet_t* packet);
+
+    /**
+     * Change the integrity mode of a link, after the board has acknowledged
+     * the SYSTEM_MODE message (see orb_transport_negotiate). The next
+     * frames are sent in the new mode and the next bytes received are
+     * decoded in the new mode. With a capture the change is recorded as a
+     * CAPTURE_MODE record, for the replay.
+     * @param gateway gateway
+     * @param link number of the link
+     * @param integrity new integrity mode (SYSTEM_INTEGRITY_*)
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_gateway_mode(gateway_t* gateway, int link, unsigned char integrity);
+
+    /**
+     * Stop the workers and close all links.
+     * @param gateway gateway
+     */
+    void orb_gateway_stop(gateway_t* gateway);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_GATEWAY_H */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_INDEX_H
+#define	OR_INDEX_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include "or_host/or_capture.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <stddef.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Magic number and version of an index file
+    #define INDEX_MAGIC 0x5849524F /* "ORIX" little endian */
+    #define INDEX_VERSION 1
+    // Max number of threads for a query
+    #define INDEX_THREADS 32
+    // Any value in a query
+    #define INDEX_ANY -1
+
+    /**
+     * Header of an index file:
+     * - magic number and version
+     * - size of this header, the entries start after it
+     * - size of the capture file indexed
+     * - number of entries
+     */
+    typedef struct _index_file {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint64_t capture;
+        uint64_t number;
+    } index_file_t;
+
+    /**
+     * A message in a capture, the entries are sorted by time:
+     * - time of the packet
+     * - offset of the CAPTURE_PACKET record in the capture
+     * - number of the link
+     * - offset of the message in the data of the packet
+     * - type, command (with index), option and length of the message
+     */
+    typedef struct _index_entry {
+        uint64_t time;
+        uint64_t offset;
+        uint16_t link;
+        uint8_t position;
+        uint8_t type;
+        uint8_t command;
+        uint8_t option;
+        uint8_t length;
+        uint8_t reserved;
+    } index_entry_t;
+
+    /**
+     * Index mapped in memory:
+     * - header
+     * - entries
+     * - size of the file
+     */
+    typedef struct _index_map {
+        const index_file_t* header;
+        const index_entry_t* entry;
+        size_t size;
+    } index_map_t;
+
+    /**
+     * Query on a capture, INDEX_ANY for all values:
+     * - time range [start, end), end 0 without limit
+     * - number of the link
+     * - type of the message
+     * - command of the message, without index (see FRAME_COMMAND_MOTOR)
+     * - index of the motor or port of the message
+     */
+    typedef struct _index_query {
+        uint64_t start;
+        uint64_t end;
+        int link;
+        int type;
+        int command;
+        int index;
+    } index_query_t;
+
+    /// function called for each message found, in order of time
+    typedef void (*index_callback_t)(void* data, const index_entry_t* entry, packet_information_t* message);
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Build the index of all messages in the CAPTURE_PACKET records of a
+     * capture. Only the headers of records and messages are read. Build
+     * again the index when the capture grows.
+     * @param capture capture mapped
+     * @param path path of the index file
+     * @return number of entries or -1 on error (see errno)
+     */
+    long orb_index_build(const capture_map_t* capture, const char* path);
+
+    /**
+     * Map an index file in memory, read only.
+     * @param index index to map
+     * @param path path of the index file
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_index_map(index_map_t* index, const char* path);
+
+    /**
+     * Unmap an index file.
+     * @param index index mapped
+     */
+    void orb_index_unmap(index_map_t* index);
+
+    /**
+     * Initialize a query for all messages.
+     * @param query query to initialize
+     */
+    void orb_index_query_init(index_query_t* query);
+
+    /**
+     * Find the messages of a query. The time range is found with a binary
+     * search, the entries in range are filtered and the messages found are
+     * read from the capture by a pool of threads. The callback is called
+     * from the caller thread, in order of time.
+     * @param capture capture mapped
+     * @param index index of the capture
+     * @param query query
+     * @param threads number of threads, max INDEX_THREADS
+     * @param callback function called for each message found, can be NULL
+     * @param data pointer passed to the callback
+     * @return number of messages found or -1 on error
+     */
+    long orb_index_query(const capture_map_t* capture, const index_map_t* index, const index_query_t* query,
+            unsigned int threads, index_callback_t callback, void* data);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_INDEX_H */
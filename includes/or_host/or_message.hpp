@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_MESSAGE_HPP
+#define	OR_MESSAGE_HPP
+
+#include "packet/frame_registry.h"
+#include "or_bus/or_registry.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+/** C++ messages
+ * Header only layer for C++ (C++11) over the registry of messages
+ * (packet/frame_registry.h):
+ * * message_traits<Type, Command> type and length of data for each message
+ * * encode<Type, Command>() write a message directly in a packet_t
+ * * decode<Type, Command>() read the data of a message from a packet_t
+ * * view<Type, Command>() data of a message in a packet_t without copy
+ * * dispatcher with typed handlers for each message
+ * Messages not in registry or data of a wrong type are compile errors.
+ */
+
+namespace orb {
+
+/**
+ * Traits of a family of messages (type):
+ * * command on the bus from command and index (motor or port)
+ * * command without index from command on the bus
+ * * index (motor or port) from command on the bus
+ */
+template<unsigned char Type>
+struct family_traits {
+    static unsigned char command(unsigned char command, unsigned char) { return command; }
+    static unsigned char base(unsigned char command) { return FRAME_COMMAND(command); }
+    static unsigned char index(unsigned char) { return 0; }
+};
+
+#if FRAME_MOTOR
+template<>
+struct family_traits<HASHMAP_MOTOR> {
+    static unsigned char command(unsigned char command, unsigned char index) { return (command << 3) | (index & 0x07); }
+    static unsigned char base(unsigned char command) { return FRAME_COMMAND_MOTOR(command); }
+    static unsigned char index(unsigned char command) { return command & 0x07; }
+};
+#endif
+
+#if FRAME_PERIPHERALS
+template<>
+struct family_traits<HASHMAP_PERIPHERALS> {
+    static unsigned char command(unsigned char command, unsigned char index) { return (command & 0x1F) | (index << 5); }
+    static unsigned char base(unsigned char command) { return FRAME_COMMAND_PERIPHERALS(command); }
+    static unsigned char index(unsigned char command) { return command >> 5; }
+};
+#endif
+
+/**
+ * Traits of a message: type of data, length and index in registry.
+ * Only the messages in registry are defined.
+ */
+template<unsigned char Type, unsigned char Command>
+struct message_traits;
+
+#define ORB_MESSAGE_TRAITS(TYPE, COMMAND, INDEX, PAYLOAD, CHECK)                                    \
+    template<>                                                                                      \
+    struct message_traits<TYPE, COMMAND> {                                                          \
+        typedef PAYLOAD payload_type;                                                               \
+        static const unsigned char type = TYPE;                                                     \
+        static const unsigned char command = COMMAND;                                               \
+        static const std::size_t length = sizeof(PAYLOAD);                                          \
+        static const bool exact = (CHECK == FRAME_CHECK_EQUAL);                                     \
+        static const int index = INDEX;                                                            \
+        static_assert(std::is_trivially_copyable<PAYLOAD>::value, #PAYLOAD " is not a POD");        \
+        static_assert(LNG_HEAD_INFORMATION_PACKET + sizeof(PAYLOAD) <= sizeof(packet_information_t),\
+                "data of " #COMMAND " does not fit in a message");                                  \
+    };
+#define ORB_MESSAGE_TRAITS_SYSTEM(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_SYSTEM, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#define ORB_MESSAGE_TRAITS_MOTOR(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_MOTOR, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#define ORB_MESSAGE_TRAITS_DIFF_DRIVE(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_DIFF_DRIVE, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#define ORB_MESSAGE_TRAITS_NAVIGATION(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_NAVIGATION, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#define ORB_MESSAGE_TRAITS_PERIPHERALS(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_PERIPHERALS, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#define ORB_MESSAGE_TRAITS_BLOCK(COMMAND, PAYLOAD, CHECK) ORB_MESSAGE_TRAITS(HASHMAP_BLOCK, COMMAND, REGISTRY_##COMMAND, PAYLOAD, CHECK)
+#if FRAME_SYSTEM
+FRAME_REGISTRY_SYSTEM(ORB_MESSAGE_TRAITS_SYSTEM)
+#endif
+#if FRAME_MOTOR
+FRAME_REGISTRY_MOTOR(ORB_MESSAGE_TRAITS_MOTOR)
+#endif
+#if FRAME_DIFF_DRIVE
+FRAME_REGISTRY_DIFF_DRIVE(ORB_MESSAGE_TRAITS_DIFF_DRIVE)
+#endif
+#if FRAME_NAVIGATION
+FRAME_REGISTRY_NAVIGATION(ORB_MESSAGE_TRAITS_NAVIGATION)
+#endif
+#if FRAME_PERIPHERALS
+FRAME_REGISTRY_PERIPHERALS(ORB_MESSAGE_TRAITS_PERIPHERALS)
+#endif
+#if FRAME_BLOCK
+FRAME_REGISTRY_BLOCK(ORB_MESSAGE_TRAITS_BLOCK)
+#endif
+#undef ORB_MESSAGE_TRAITS_SYSTEM
+#undef ORB_MESSAGE_TRAITS_MOTOR
+#undef ORB_MESSAGE_TRAITS_DIFF_DRIVE
+#undef ORB_MESSAGE_TRAITS_NAVIGATION
+#undef ORB_MESSAGE_TRAITS_PERIPHERALS
+#undef ORB_MESSAGE_TRAITS_BLOCK
+#undef ORB_MESSAGE_TRAITS
+
+/**
+ * Write the header of a message in tail of a packet.
+ * @return pointer to data of message or NULL if the message does not fit
+ */
+inline unsigned char* encode_header(packet_t& packet, unsigned char option, unsigned char type, unsigned char command, std::size_t length) {
+    std::size_t size = LNG_HEAD_INFORMATION_PACKET + length;
+    if(packet.length + size > MAX_BUFF_TX) {
+        return NULL;
+    }
+    unsigned char* message = &packet.buffer[packet.length];
+    message[0] = (unsigned char) size;
+    message[1] = option;
+    message[2] = type;
+    message[3] = command;
+    packet.length += size;
+    return message + LNG_HEAD_INFORMATION_PACKET;
+}
+
+/**
+ * Write a message with data (D) directly in tail of a packet, without copy
+ * in a packet_information_t.
+ * Example: orb::encode<HASHMAP_MOTOR, MOTOR_VEL_PID>(packet, pid, motor);
+ * @param packet packet to send
+ * @param payload data of message
+ * @param index index of motor or port (only for motor and peripherals)
+ * @return false if the message does not fit in the packet
+ */
+template<unsigned char Type, unsigned char Command>
+bool encode(packet_t& packet, const typename message_traits<Type, Command>::payload_type& payload, unsigned char index = 0) {
+    typedef message_traits<Type, Command> traits;
+    unsigned char* data = encode_header(packet, PACKET_DATA, Type, family_traits<Type>::command(Command, index), traits::length);
+    if(data == NULL) {
+        return false;
+    }
+    std::memcpy(data, &payload, traits::length);
+    return true;
+}
+
+/**
+ * Write a request (R) in tail of a packet.
+ * @param packet packet to send
+ * @param index index of motor or port (only for motor and peripherals)
+ * @return false if the message does not fit in the packet
+ */
+template<unsigned char Type, unsigned char Command>
+bool encode_request(packet_t& packet, unsigned char index = 0) {
+    static_assert(message_traits<Type, Command>::length > 0, "message not in registry");
+    return encode_header(packet, PACKET_REQUEST, Type, family_traits<Type>::command(Command, index), 0) != NULL;
+}
+
+/**
+ * Verify if a message in a packet is a Type, Command message with a valid
+ * length of data.
+ * @param message pointer to the first byte (length) of a message
+ */
+template<unsigned char Type, unsigned char Command>
+bool is_message(const unsigned char* message) {
+    typedef message_traits<Type, Command> traits;
+    std::size_t length = message[0] - LNG_HEAD_INFORMATION_PACKET;
+    if(message[0] < LNG_HEAD_INFORMATION_PACKET || message[2] != Type
+            || family_traits<Type>::base(message[3]) != Command) {
+        return false;
+    }
+    return traits::exact ? length == traits::length : length <= traits::length;
+}
+
+/**
+ * Read the data of a message in a packet.
+ * @param message pointer to the first byte (length) of a message
+ * @param payload data of message
+ * @return false if the message is not a Type, Command message
+ */
+template<unsigned char Type, unsigned char Command>
+bool decode(const unsigned char* message, typename message_traits<Type, Command>::payload_type& payload) {
+    if(!is_message<Type, Command>(message)) {
+        return false;
+    }
+    std::memcpy(&payload, message + LNG_HEAD_INFORMATION_PACKET, message[0] - LNG_HEAD_INFORMATION_PACKET);
+    return true;
+}
+
+/**
+ * View of the data of a message directly in the buffer received, without
+ * any copy. Only for packed structures (see packet/wire.h) on a little
+ * endian host, for scalar messages use decode.
+ * @param message pointer to the first byte (length) of a message
+ * @return pointer to data or NULL if the message is not a Type, Command
+ * message with all data
+ */
+template<unsigned char Type, unsigned char Command>
+const typename message_traits<Type, Command>::payload_type* view(const unsigned char* message) {
+    typedef message_traits<Type, Command> traits;
+    typedef typename traits::payload_type payload_type;
+    static_assert(alignof(payload_type) == 1, "data is not a packed structure, use decode");
+    static_assert(!WIRE_BIG_ENDIAN, "view is available only on little endian hosts, use decode");
+    if(!is_message<Type, Command>(message) || message[0] != LNG_HEAD_INFORMATION_PACKET + traits::length) {
+        return NULL;
+    }
+    return reinterpret_cast<const payload_type*>(message + LNG_HEAD_INFORMATION_PACKET);
+}
+
+/**
+ * Call a function for each message in a packet, with a pointer to the first
+ * byte of the message. Stop on a message with a wrong length.
+ * @return number of messages
+ */
+template<typename Function>
+std::size_t for_each_message(const packet_t& packet, Function function) {
+    std::size_t i = 0, number = 0;
+    while(i < packet.length) {
+        unsigned char length = packet.buffer[i];
+        if(length < LNG_HEAD_INFORMATION_PACKET || i + length > packet.length) {
+            break;
+        }
+        function(&packet.buffer[i]);
+        i += length;
+        number++;
+    }
+    return number;
+}
+
+/**
+ * Dispatcher of messages to typed handlers, with a direct jump from the
+ * index in registry of the message.
+ * Example:
+ *      dispatcher.on<HASHMAP_MOTOR, MOTOR_MEASURE>([](unsigned char option, unsigned char motor, const motor_t& measure) {...});
+ *      dispatcher.dispatch(packet);
+ */
+class dispatcher {
+public:
+    typedef std::function<void(unsigned char, unsigned char, const unsigned char*)> handler_type;
+
+    /**
+     * Register a typed handler for a message.
+     * @param handler function(option, index of motor or port, data)
+     */
+    template<unsigned char Type, unsigned char Command, typename Function>
+    void on(Function handler) {
+        typedef message_traits<Type, Command> traits;
+        handlers_[traits::index] = [handler](unsigned char option, unsigned char command, const unsigned char* message) {
+            if(!is_message<Type, Command>(message)) {
+                return;
+            }
+            typename traits::payload_type payload;
+            std::memset(&payload, 0, sizeof(payload));
+            std::memcpy(&payload, message + LNG_HEAD_INFORMATION_PACKET, message[0] - LNG_HEAD_INFORMATION_PACKET);
+            handler(option, family_traits<Type>::index(command), payload);
+        };
+    }
+
+    /**
+     * Send a message to the registered handler.
+     * @return false if there is not a handler for this message
+     */
+    bool dispatch(const unsigned char* message) {
+        int index = orb_registry_index(message[2], message[3]);
+        if(index == REGISTRY_UNKNOWN || !handlers_[index]) {
+            return false;
+        }
+        handlers_[index](message[1], message[3], message);
+        return true;
+    }
+
+    /**
+     * Send all messages in a packet to the registered handlers.
+     * @return number of messages in packet
+     */
+    std::size_t dispatch(const packet_t& packet) {
+        return for_each_message(packet, [this](const unsigned char* message) { dispatch(message); });
+    }
+
+private:
+    handler_type handlers_[REGISTRY_NUMBER];
+};
+
+} // namespace orb
+
+#endif	/* OR_MESSAGE_HPP */
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_MIRROR_H
+#define	OR_MIRROR_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include "packet/frame_registry.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Max number of messages in a mirror
+    #define MIRROR_SIZE 64
+    
+    /** Staleness policy of a message */
+    // The message does not change on the board (SYSTEM_CODE_*), never stale
+    #define MIRROR_STATIC 0
+    // The message is stale after max_age from the last reply or write
+    #define MIRROR_AGE 1
+
+    /// timer of the host
+    typedef unsigned int (*mirror_clock_t)(void);
+
+    /**
+     * A message in the mirror:
+     * - type and command (with the index of motor or port, see
+     *   FRAME_INDEX_MOTOR and FRAME_INDEX_PERIPHERALS)
+     * - staleness policy and max age
+     * - true if the message has a value
+     * - time of the last value
+     * - last value
+     */
+    typedef struct _mirror_entry {
+        unsigned char type;
+        unsigned char command;
+        unsigned char policy;
+        unsigned int age;
+        bool valid;
+        unsigned int time;
+        packet_information_t message;
+    } mirror_entry_t;
+
+    /**
+     * Mirror of the messages of a board:
+     * - messages
+     * - number of messages
+     * - timer of the host
+     */
+    typedef struct _mirror {
+        mirror_entry_t entry[MIRROR_SIZE];
+        unsigned int number;
+        mirror_clock_t clock;
+    } mirror_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Initialize a mirror without messages.
+     * @param mirror mirror of a board
+     * @param clock timer of the host
+     */
+    void orb_mirror_init(mirror_t* mirror, mirror_clock_t clock);
+
+    /**
+     * Add a message in the mirror.
+     * Example:
+     *      orb_mirror_register(&mirror, HASHMAP_SYSTEM, SYSTEM_CODE_VERSION, MIRROR_STATIC, 0);
+     *      orb_mirror_register(&mirror, HASHMAP_MOTOR, FRAME_INDEX_MOTOR(MOTOR_POS_PID, 0), MIRROR_AGE, 1000);
+     * @param mirror mirror of a board
+     * @param type type of the message
+     * @param command command of the message, with index
+     * @param policy MIRROR_STATIC or MIRROR_AGE
+     * @param age max age of the value for MIRROR_AGE
+     * @return false if the mirror is full
+     */
+    bool orb_mirror_register(mirror_t* mirror, unsigned char type, unsigned char command, unsigned char policy, unsigned int age);
+
+    /**
+     * Read a message from the mirror, without bus round trip.
+     * @param mirror mirror of a board
+     * @param type type of the message
+     * @param command command of the message, with index
+     * @param message copy of the value
+     * @return false if the message is not in the mirror or the value is
+     * stale, send a request (R) and update the mirror with the reply
+     */
+    bool orb_mirror_read(mirror_t* mirror, unsigned char type, unsigned char command, packet_information_t* message);
+
+    /**
+     * Update the mirror with a message received, a reply or a message
+     * streamed from the board. A data (D) message is the new value, a NACK
+     * invalidates the value.
+     * @param mirror mirror of a board
+     * @param message message received
+     * @return true if the message is in the mirror
+     */
+    bool orb_mirror_update(mirror_t* mirror, packet_information_t* message);
+
+    /**
+     * Write through: the value of a data (D) message to send is the new
+     * value in the mirror, a patch (P) is applied to the value in the
+     * mirror. A NACK reply for the message invalidates it (see
+     * orb_mirror_callback and orb_mirror_window).
+     * @param mirror mirror of a board
+     * @param message message to send
+     * @return true if the message is in the mirror
+     */
+    bool orb_mirror_write(mirror_t* mirror, packet_information_t* message);
+
+    /**
+     * Invalidate a value in the mirror.
+     * @param mirror mirror of a board
+     * @param type type of the message
+     * @param command command of the message, with index
+     */
+    void orb_mirror_invalidate(mirror_t* mirror, unsigned char type, unsigned char command);
+
+    /**
+     * Callback for the client (see or_host/or_client.h) to update the
+     * mirror with all replies and messages without request. A write (D or
+     * P) completed with CLIENT_TIMEOUT invalidates the value.
+     * Example:
+     *      orb_client_init(&client, timeout, orb_mirror_callback, &mirror);
+     *      orb_client_request(&client, type, command, orb_mirror_callback, &mirror);
+     * @param data mirror of the board
+     * @param message message received
+     * @param result result of the client
+     */
+    void orb_mirror_callback(void* data, packet_information_t* message, unsigned char result);
+
+    /**
+     * Callback for the window of writes with sequence number (see
+     * or_host/or_window.h): a write completed with WINDOW_NACK or
+     * WINDOW_TIMEOUT invalidates the value written through.
+     * Example:
+     *      orb_window_init(&window, timeout, 3, orb_mirror_window, &mirror);
+     *      orb_mirror_write(&mirror, &message);
+     *      orb_window_push(&window, &message);
+     * @param data mirror of the board
+     * @param message message written
+     * @param result result of the write
+     */
+    void orb_mirror_window(void* data, packet_information_t* message, unsigned char result);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_MIRROR_H */
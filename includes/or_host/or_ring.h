@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_RING_H
+#define	OR_RING_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <stddef.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Default number of messages in a ring, power of two
+    #define RING_SLOTS 1024
+    // Magic number of a ring in shared memory
+    #define RING_MAGIC 0x4F524230
+    
+    /** Result of a read */
+    #define RING_DATA 1
+    #define RING_EMPTY 0
+    #define RING_OVERRUN -1
+
+    /**
+     * A message in the ring. The sequence is odd while the writer copies the
+     * message and 2 * (position + 1) when the message at position is
+     * complete.
+     */
+    typedef struct _ring_slot {
+        volatile uint32_t sequence;
+        packet_information_t message;
+    } ring_slot_t;
+
+    /**
+     * Header of a ring in shared memory, followed by the slots:
+     * - magic number
+     * - number of slots (power of two)
+     * - position of the next message to write
+     */
+    typedef struct _ring_header {
+        uint32_t magic;
+        uint32_t slots;
+        volatile uint32_t head;
+    } ring_header_t;
+
+    /**
+     * A ring mapped in this process:
+     * - header in shared memory
+     * - slots in shared memory
+     * - size of the mapping
+     * - true for the writer
+     */
+    typedef struct _ring {
+        ring_header_t* header;
+        ring_slot_t* slot;
+        size_t size;
+        bool writer;
+    } ring_t;
+
+    /**
+     * Cursor of a reader, in the memory of the reader:
+     * - ring to read
+     * - position of the next message to read
+     * - number of messages lost after an overrun
+     */
+    typedef struct _ring_reader {
+        ring_t* ring;
+        uint32_t position;
+        uint32_t lost;
+    } ring_reader_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Create a ring in shared memory (shm_open), for the writer. A ring has
+     * one writer: with the gateway, one ring for each link.
+     * @param ring ring to map
+     * @param name name of the shared memory, "/or_link0"
+     * @param slots number of messages, power of two (RING_SLOTS)
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_ring_create(ring_t* ring, const char* name, uint32_t slots);
+
+    /**
+     * Map a ring in shared memory, read only, for the readers.
+     * @param ring ring to map
+     * @param name name of the shared memory
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_ring_open(ring_t* ring, const char* name);
+
+    /**
+     * Unmap a ring. The writer removes the name of the shared memory.
+     * @param ring ring to unmap
+     * @param name name of the shared memory, NULL to keep it
+     */
+    void orb_ring_close(ring_t* ring, const char* name);
+
+    /**
+     * Write a message in the ring. The writer never waits the readers, the
+     * oldest message is overwritten.
+     * @param ring ring of the writer
+     * @param message message to publish
+     */
+    void orb_ring_publish(ring_t* ring, packet_information_t* message);
+
+    /**
+     * Write all messages of a packet decoded with decode_pkgs.
+     * @param ring ring of the writer
+     * @param packet packet received
+     * @return number of messages published
+     */
+    unsigned int orb_ring_publish_packet(ring_t* ring, packet_t* packet);
+
+    /**
+     * Initialize the cursor of a reader on the next message published.
+     * @param reader cursor of the reader
+     * @param ring ring to read
+     */
+    void orb_ring_reader_init(ring_reader_t* reader, ring_t* ring);
+
+    /**
+     * Start to read the next message in place, without copies and syscalls.
+     * The message is in the slot of the ring and the writer can overwrite
+     * it during the read: the values read are valid only if orb_ring_end
+     * returns RING_DATA, otherwise they are discarded and the read starts
+     * again. After an overrun the cursor moves on the oldest message in the
+     * ring and the messages overwritten are added in lost.
+     * Example:
+     *      while((result = orb_ring_begin(&reader, &message)) != RING_EMPTY) {
+     *          if(result == RING_DATA) {
+     *              reference = message->message.motor.reference;
+     *              if(orb_ring_end(&reader) == RING_DATA) {
+     *                  use(reference);
+     *              }
+     *          }
+     *      }
+     * @param reader cursor of the reader
+     * @param message pointer to the message in the ring
+     * @return RING_DATA, RING_EMPTY or RING_OVERRUN
+     */
+    int orb_ring_begin(ring_reader_t* reader, const packet_information_t** message);
+
+    /**
+     * Validate a read started with orb_ring_begin and move the cursor on the
+     * next message.
+     * @param reader cursor of the reader
+     * @return RING_DATA if the message was not overwritten during the read,
+     * RING_OVERRUN otherwise
+     */
+    int orb_ring_end(ring_reader_t* reader);
+
+    /**
+     * Read the next message without syscalls, with a copy of the message
+     * (see orb_ring_begin). After an overrun the cursor moves on the oldest
+     * message in the ring and the messages overwritten are added in lost.
+     * @param reader cursor of the reader
+     * @param message message read
+     * @return RING_DATA, RING_EMPTY or RING_OVERRUN
+     */
+    int orb_ring_read(ring_reader_t* reader, packet_information_t* message);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_RING_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_TRANSFER_H
+#define	OR_TRANSFER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include "or_host/or_transport.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+
+#if FRAME_BLOCK
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Default number of chunks in a block
+    #define TRANSFER_WINDOW 32
+    // Max number of chunks in a block
+    #define TRANSFER_WINDOW_MAX 64
+    // Attempts for a block without progress or for a state without reply
+    #define TRANSFER_RETRY 8
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Read the state of an area of the board (see or_bus/or_block.h).
+     * @param transport link with the board
+     * @param area number of the area
+     * @param timeout max time to wait the reply (ms), the request is sent
+     * again after a timeout, max TRANSFER_RETRY times
+     * @param state state of the area: size and offset verified
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_transfer_state(transport_t* transport, unsigned char area, int timeout, block_state_t* state);
+
+    /**
+     * Write data in an area of the board, in blocks of window chunks. The
+     * chunks of a block fill whole frames, the block is verified from the
+     * board with a CRC16 and sent again if it is not verified.
+     * Example, resume an interrupted write:
+     *      orb_transfer_state(&link, 0, 1000, &state);
+     *      offset = state.offset;
+     *      orb_transfer_write(&link, 0, image, size, &offset, 0, 1000);
+     * @param transport link with the board
+     * @param area number of the area
+     * @param data data to write, from the first byte of the area
+     * @param size size of data
+     * @param offset offset to start (0 or lower than the offset verified of
+     * the board), updated with the offset verified
+     * @param window chunks in a block, 0 for TRANSFER_WINDOW
+     * @param timeout max time to wait each reply (ms)
+     * @return 0 or -1 on error (see errno), the write can be resumed from
+     * offset
+     */
+    int orb_transfer_write(transport_t* transport, unsigned char area, const void* data, uint32_t size, uint32_t* offset, unsigned int window, int timeout);
+
+    /**
+     * Read data from an area of the board, in blocks of window chunks
+     * verified with the CRC16 of the board.
+     * @param transport link with the board
+     * @param area number of the area
+     * @param data buffer for data, from the first byte of the area
+     * @param size size of data to read
+     * @param offset offset to start, updated with the offset of data read
+     * @param window chunks in a block, 0 for TRANSFER_WINDOW
+     * @param timeout max time to wait each block (ms)
+     * @return 0 or -1 on error (see errno), the read can be resumed from
+     * offset
+     */
+    int orb_transfer_read(transport_t* transport, unsigned char area, void* data, uint32_t size, uint32_t* offset, unsigned int window, int timeout);
+
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_TRANSFER_H */
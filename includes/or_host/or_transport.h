@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_TRANSPORT_H
+#define	OR_TRANSPORT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include "or_bus/or_message.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Bytes read from a transport for each read
+    #define TRANSPORT_READ 1024
+    // Default speed of a serial transport
+    #define TRANSPORT_BAUD 115200
+    // Max number of segments in a frame
+    #define TRANSPORT_SEGMENTS 64
+
+    typedef struct _transport transport_t;
+
+    /**
+     * Operations of a transport:
+     * - open the link of an address
+     * - write a vector of buffers, a frame in a single write
+     * - read the next chunk of bytes
+     * - wait data for a timeout (ms, -1 without timeout), > 0 with data
+     * - close the link
+     * - integrity modes safe on the link (mask of SYSTEM_INTEGRITY_*)
+     */
+    typedef struct _transport_ops {
+        int (*open)(transport_t* transport, const char* address);
+        ssize_t (*writev)(transport_t* transport, const struct iovec* vector, int count);
+        ssize_t (*read)(transport_t* transport, void* buffer, size_t size);
+        int (*poll)(transport_t* transport, int timeout);
+        void (*close)(transport_t* transport);
+        unsigned char integrity;
+    } transport_ops_t;
+
+    /**
+     * A link with the framing of or_bus:
+     * - operations of the transport
+     * - file descriptor
+     * - decoder of the link (with the integrity mode) and packet in decoding
+     * - counters of the errors of the decoder
+     * - max length of data in a frame for the peer
+     */
+    struct _transport {
+        const transport_ops_t* ops;
+        int fd;
+        unsigned char size;
+        decoder_t decoder;
+        packet_t packet;
+        system_error_serial_t error;
+    };
+
+    /// function called for each packet received
+    typedef void (*transport_callback_t)(void* data, packet_t* packet);
+
+    /**
+     * Transports:
+     * - serial tty, address "/dev/ttyUSB0" or "/dev/ttyUSB0@115200", from
+     *   9600 to 921600 baud (EINVAL with another speed)
+     * - UNIX socket (stream), address "/tmp/board" to connect or
+     *   "+/tmp/board" to wait the connection of a peer
+     * - UDP, address "local_port@host:port"
+     */
+    extern const transport_ops_t transport_serial;
+    extern const transport_ops_t transport_unix;
+    extern const transport_ops_t transport_udp;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Open a link.
+     * Example, two links on UDP loopback:
+     *      orb_transport_open(&host, &transport_udp, "5001@127.0.0.1:5002");
+     *      orb_transport_open(&board, &transport_udp, "5002@127.0.0.1:5001");
+     * @param transport link to open
+     * @param ops operations of the transport
+     * @param address address of the link
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_transport_open(transport_t* transport, const transport_ops_t* ops, const char* address);
+
+    /**
+     * Send a packet with header and check of the integrity mode of the link,
+     * as build_pkg, in a single write of the transport.
+     * @param transport link
+     * @param packet packet to send
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_transport_send(transport_t* transport, packet_t* packet);
+
+    /**
+     * Send a frame with the data in segments, without copy in a contiguous
+     * buffer: header, segments and checksum in a single writev.
+     * @param transport link
+     * @param segment segments of the data, max size bytes of the link
+     * @param count number of segments, max TRANSPORT_SEGMENTS
+     * @return 0 or -1 on error (see errno)
+     */
+    int orb_transport_sendv(transport_t* transport, const struct iovec* segment, int count);
+
+    /**
+     * Send messages already encoded (from a list, a cache or a mirror) in a
+     * frame, each message is a segment. The messages over the max size of
+     * the link are not sent, as encoder.
+     * @param transport link
+     * @param message messages to send
+     * @param number number of messages
+     * @return number of messages sent (0 without messages, nothing is
+     * written) or -1 on error (see errno), EMSGSIZE if the first message is
+     * larger than the frame of the link
+     */
+    int orb_transport_send_messages(transport_t* transport, packet_information_t* const* message, size_t number);
+
+    /**
+     * Negotiate the mode of the link with the board: request the capability
+     * of the board and switch the link to the fastest integrity mode in
+     * common (none, sum, CRC16). A board without SYSTEM_CAPABILITY replies
+     * NACK and the link stays with the sum. A board in the mode of a
+     * previous connection, or switched with a lost ACK, is found requesting
+     * the capability in the other modes. Call this function before any
+     * other message, the packets received during the negotiation are lost.
+     * Example:
+     *      orb_transport_negotiate(&link, link.ops->integrity, 1000, &capability);
+     * @param transport link
+     * @param integrity integrity modes allowed (mask of SYSTEM_INTEGRITY_*)
+     * @param timeout max time to wait each reply (ms)
+     * @param capability capability of the board, can be NULL
+     * @return integrity mode of the link or -1 on error (see errno)
+     */
+    int orb_transport_negotiate(transport_t* transport, unsigned char integrity, int timeout, system_capability_t* capability);
+
+    /**
+     * Wait the data of the link, decode them and call the callback for each
+     * packet received.
+     * @param transport link
+     * @param timeout max time to wait (ms), -1 without timeout
+     * @param callback function called for each packet
+     * @param data pointer passed to the callback
+     * @return number of packets received or -1 if the link is closed or on
+     * an error of poll (see errno)
+     */
+    int orb_transport_receive(transport_t* transport, int timeout, transport_callback_t callback, void* data);
+
+    /**
+     * Close a link.
+     * @param transport link
+     */
+    void orb_transport_close(transport_t* transport);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_TRANSPORT_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OR_WINDOW_H
+#define	OR_WINDOW_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "packet/packet.h"
+#include <stdint.h>          /* For uint16_t definition                       */
+#include <stdbool.h>         /* For true/false definition                     */
+#include <string.h>
+
+/******************************************************************************/
+/* System Level #define Macros                                                */
+/******************************************************************************/
+    // Max number of writes in flight
+    #define WINDOW_SIZE 8
+    
+    /** Result of a write */
+    #define WINDOW_ACK 0
+    #define WINDOW_NACK 1
+    #define WINDOW_TIMEOUT 2
+    // Replaced from a newer write of the same message, not sent again
+    #define WINDOW_SUPERSEDED 3
+    
+    /// function called when a write is completed
+    typedef void (*window_callback_t)(void* data, packet_information_t* message, unsigned char result);
+
+    /**
+     * A write in flight:
+     * - message to write (without sequence number)
+     * - sequence number
+     * - state of the write
+     * - number of transmissions
+     * - time of the last transmission
+     */
+    typedef struct _window_entry {
+        packet_information_t message;
+        unsigned char sequence;
+        unsigned char state;
+        unsigned char transmissions;
+        unsigned int time;
+    } window_entry_t;
+
+    /**
+     * Window of writes with sequence numbers (Q) on a link:
+     * - writes in flight
+     * - next sequence number
+     * - time before a retransmission
+     * - max number of transmissions for each write
+     * - function (and data) called when a write is completed
+     */
+    typedef struct _window {
+        window_entry_t entry[WINDOW_SIZE];
+        unsigned char sequence;
+        unsigned int timeout;
+        unsigned char transmissions;
+        window_callback_t callback;
+        void* data;
+    } window_t;
+
+/******************************************************************************/
+/* System Function Prototypes                                                 */
+/******************************************************************************/
+    /**
+     * Initialize an empty window.
+     * @param window window to initialize
+     * @param timeout time without ACK or NACK before a retransmission
+     * @param transmissions max number of transmissions of a write
+     * @param callback function called with the result of each write, can be NULL
+     * @param data pointer passed to the callback
+     */
+    void orb_window_init(window_t* window, unsigned int timeout, unsigned char transmissions, window_callback_t callback, void* data);
+
+    /**
+     * Add a write (D) in the window. The message is sent with the next
+     * orb_window_encode. A write of the same message (type and command)
+     * still in the window is completed with WINDOW_SUPERSEDED: a
+     * retransmission of the old value can not arrive after the new one.
+     * @param window window of writes
+     * @param message message with data to write
+     * @return sequence number of the write or -1 if the window is full
+     */
+    int orb_window_push(window_t* window, packet_information_t* message);
+
+    /**
+     * Append in a packet all new writes and the writes without reply after
+     * the timeout, with the sequence number in tail (Q), in order of
+     * sequence. The writes over the max number of transmissions are
+     * completed with WINDOW_TIMEOUT.
+     * @param window window of writes
+     * @param packet packet to send, the messages are appended after length
+     * @param now current time
+     * @return number of messages appended
+     */
+    unsigned int orb_window_encode(window_t* window, packet_t* packet, unsigned int now);
+
+    /**
+     * Complete a write with an ACK or NACK reply with sequence number.
+     * @param window window of writes
+     * @param reply message received
+     * @return true if the reply is for a write in the window
+     */
+    bool orb_window_reply(window_t* window, packet_information_t* reply);
+
+    /**
+     * @param window window of writes
+     * @return number of writes in flight
+     */
+    unsigned int orb_window_pending(window_t* window);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OR_WINDOW_H */
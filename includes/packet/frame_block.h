@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef FRAME_BLOCK_H
+#define	FRAME_BLOCK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include "packet/wire.h"
+
+//Name for HASHMAP with information about block transfer messages
+#define HASHMAP_BLOCK 'B'
+
+// Bytes of data in a chunk, a chunk fills the data of a message
+#define MAX_BUFF_BLOCK_CHUNK 27
+
+/**
+ * State of the transfer of an area (firmware, calibration, log, ...):
+ * - [#] number of area
+ * - [B] size of area
+ * - [B] offset of data written and verified, the transfer resumes from here
+ * A (D) message starts the write of an area from an offset, lower or equal
+ * to the offset verified. A request (R) with the number of area in tail
+ * returns the state of the area.
+ */
+typedef struct __attribute__ ((__packed__)) _block_state {
+    uint8_t area;
+    uint32_t size;
+    uint32_t offset;
+} block_state_t;
+#define LNG_BLOCK_STATE sizeof(block_state_t)
+WIRE_STATIC_ASSERT(LNG_BLOCK_STATE == 9, block_state_t);
+
+/**
+ * Chunk of data of the area in transfer:
+ * - [B] offset of data in the area
+ * - [B] number of bytes of data
+ * - [#] data
+ * The chunks of a write (D) are accepted only in order, without reply. A
+ * request (R) with offset and length in tail returns a chunk of the area.
+ */
+typedef struct __attribute__ ((__packed__)) _block_chunk {
+    uint32_t offset;
+    uint8_t length;
+    uint8_t data[MAX_BUFF_BLOCK_CHUNK];
+} block_chunk_t;
+#define LNG_BLOCK_CHUNK sizeof(block_chunk_t)
+#define LNG_HEAD_BLOCK_CHUNK 5
+WIRE_STATIC_ASSERT(LNG_BLOCK_CHUNK == LNG_HEAD_BLOCK_CHUNK + MAX_BUFF_BLOCK_CHUNK, block_chunk_t);
+
+/**
+ * Check of a block of the area in transfer:
+ * - [B] offset of the block
+ * - [B] length of the block
+ * - [#] CRC16 CCITT of data of the block
+ * A (D) message verifies the chunks written after the last block and the
+ * board replies with the state. A request (R) with offset and length in
+ * tail returns the check of data in the area.
+ */
+typedef struct __attribute__ ((__packed__)) _block_check {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t crc;
+} block_check_t;
+#define LNG_BLOCK_CHECK sizeof(block_check_t)
+WIRE_STATIC_ASSERT(LNG_BLOCK_CHECK == 8, block_check_t);
+
+/**
+ * List of all block transfer messages
+ */
+typedef union _block_frame {
+    block_state_t state;
+    block_chunk_t chunk;
+    block_check_t check;
+} block_frame_u;
+
+//Number association for block transfer messages
+#define BLOCK_STATE     0
+#define BLOCK_CHUNK     1
+#define BLOCK_CHECK     2
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FRAME_BLOCK_H */
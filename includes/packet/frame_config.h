@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef FRAMECONFIG_H
+#define	FRAMECONFIG_H
+
+/** Families of messages
+ * Every family of messages can be removed from the build, defining the
+ * macro to 0 in the preprocessor macros of the project (e.g. -DFRAME_NAVIGATION=0).
+ * A family removed is not in message_abstract_u, in the registry and in the
+ * parser, then every packet_information_t is sized only on the families in
+ * use. The size of all messages is printed with tools/frame_report.c
+ * The header of system messages is always included, the serial errors are
+ * used from the decoder.
+ */
+
+/*******/
+
+#ifndef FRAME_SYSTEM
+#define FRAME_SYSTEM 1
+#endif
+
+#ifndef FRAME_MOTOR
+#define FRAME_MOTOR 1
+#endif
+
+#ifndef FRAME_DIFF_DRIVE
+#define FRAME_DIFF_DRIVE 1
+#endif
+
+#ifndef FRAME_NAVIGATION
+#define FRAME_NAVIGATION 1
+#endif
+
+#ifndef FRAME_PERIPHERALS
+#define FRAME_PERIPHERALS 1
+#endif
+
+#ifndef FRAME_BLOCK
+#define FRAME_BLOCK 1
+#endif
+
+/// Number of families in use
+#define FRAME_FAMILIES (FRAME_SYSTEM + FRAME_MOTOR + FRAME_DIFF_DRIVE + FRAME_NAVIGATION + FRAME_PERIPHERALS + FRAME_BLOCK)
+
+#endif	/* FRAMECONFIG_H */
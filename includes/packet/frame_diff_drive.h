@@ -19,6 +19,7 @@
 #define	FRAMEDIFFDRIVE_H
 
 #include <stdint.h>
+#include "packet/wire.h"
 
 //Name for HASHMAP with information about motion messages
 #define HASHMAP_DIFF_DRIVE 'M'
@@ -41,6 +42,7 @@ typedef struct __attribute__ ((__packed__)) _coordinate {
     float space;
 } diff_drive_coordinate_t;
 #define LNG_DIFF_DRIVE_COORDINATE sizeof(diff_drive_coordinate_t)
+WIRE_STATIC_ASSERT(LNG_DIFF_DRIVE_COORDINATE == 16, diff_drive_coordinate_t);
 
 /**
  * Parameters definition for unicycle robot:
@@ -55,6 +57,7 @@ typedef struct __attribute__ ((__packed__)) _parameter_unicycle {
     float sp_min;
 } diff_drive_parameter_unicycle_t;
 #define LNG_DIFF_DRIVE_PARAMETER_UNICYCLE sizeof(diff_drive_parameter_unicycle_t)
+WIRE_STATIC_ASSERT(LNG_DIFF_DRIVE_PARAMETER_UNICYCLE == 16, diff_drive_parameter_unicycle_t);
 
 /**
  * Message for read and write velocity in a unicycle robot:
@@ -66,12 +69,14 @@ typedef struct __attribute__ ((__packed__)) _velocity {
     float w;
 } diff_drive_velocity_t;
 #define LNG_DIFF_DRIVE_VELOCITY sizeof(diff_drive_velocity_t)
+WIRE_STATIC_ASSERT(LNG_DIFF_DRIVE_VELOCITY == 8, diff_drive_velocity_t);
 
 /**
  * Message for read and write state high level control
  */
 typedef int8_t diff_drive_state_t;
 #define LNG_DIFF_DRIVE_STATE sizeof(diff_drive_state_t)
+WIRE_STATIC_ASSERT(LNG_DIFF_DRIVE_STATE == 1, diff_drive_state_t);
 
 /**
  * List of all motion messages
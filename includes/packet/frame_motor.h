@@ -19,6 +19,7 @@
 #define	FRAMEMOTOR_H
 
 #include <stdint.h>
+#include "packet/wire.h"
 
 //Name for HASHMAP with information about motion messages
 #define HASHMAP_MOTOR 'G'
@@ -56,6 +57,7 @@ typedef union _motor_command_map {
 #define MOTOR_CONTROL_MIN INT32_MIN
 typedef int32_t motor_control_t;
 #define LNG_MOTOR_CONTROL sizeof(motor_control_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_CONTROL == 4, motor_control_t);
 
 /**
  * Message to get status of a single motor
@@ -63,6 +65,7 @@ typedef int32_t motor_control_t;
  */
 typedef int8_t motor_state_t;
 #define LNG_MOTOR_STATE sizeof(motor_state_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_STATE == 1, motor_state_t);
 
 /**
  * Message for the status of the motor controller, information about:
@@ -82,6 +85,7 @@ typedef struct __attribute__ ((__packed__)) _motor {
     float position_delta;
 } motor_t;
 #define LNG_MOTOR sizeof(motor_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR == 24, motor_t);
 
 /**
  * All diagnostic information about state of motor
@@ -99,6 +103,7 @@ typedef struct __attribute__ ((__packed__)) _motor_diagnostic {
     uint32_t time_control;
 } motor_diagnostic_t;
 #define LNG_MOTOR_DIAGNOSTIC sizeof(motor_diagnostic_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_DIAGNOSTIC == 13, motor_diagnostic_t);
 
 /**
  * Encoder type definition:
@@ -112,12 +117,13 @@ typedef struct __attribute__ ((__packed__)) _motor_diagnostic {
 #define MOTOR_ENC_Z_INDEX_YES 1
 #define MOTOR_ENC_CHANNEL_ONE 0
 #define MOTOR_ENC_CHANNEL_TWO 1
-typedef struct _encoder_type {
+typedef struct __attribute__ ((__packed__)) _encoder_type {
         uint8_t position;
         uint8_t z_index;
         uint8_t channels;
         uint8_t          : 5;
 } motor_encoder_type_t;
+WIRE_STATIC_ASSERT(sizeof(motor_encoder_type_t) == 4, motor_encoder_type_t);
 /**
  * Encoder parameters definition:
  * - [#]     Encoder CPR
@@ -128,6 +134,7 @@ typedef struct __attribute__ ((__packed__)) _motor_parameter_encoder {
     motor_encoder_type_t type;
 } motor_parameter_encoder_t;
 #define LNG_MOTOR_PARAMETER_ENCODER sizeof(motor_parameter_encoder_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_PARAMETER_ENCODER == 6, motor_parameter_encoder_t);
 
 /**
  * Parameters definition for motor:
@@ -150,6 +157,7 @@ typedef struct __attribute__ ((__packed__)) _motor_parameter_bridge {
     float current_gain;
 } motor_parameter_bridge_t;
 #define LNG_MOTOR_PARAMETER_BRIDGE sizeof(motor_parameter_bridge_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_PARAMETER_BRIDGE == 21, motor_parameter_bridge_t);
 /**
  * Collection of parameters to configure bridge and encoder
  * - Bridge configuration parameters
@@ -166,6 +174,7 @@ typedef struct __attribute__ ((__packed__)) _motor_parameter {
     motor_parameter_encoder_t encoder;
 } motor_parameter_t;
 #define LNG_MOTOR_PARAMETER sizeof(motor_parameter_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_PARAMETER == 32, motor_parameter_t);
 
 /**
  * Message to launch the safety stop motor
@@ -179,6 +188,7 @@ typedef struct __attribute__ ((__packed__)) _motor_safety {
     uint32_t autorestore;
 } motor_safety_t;
 #define LNG_MOTOR_SAFETY sizeof(motor_safety_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_SAFETY == 12, motor_safety_t);
 /**
  * Message for emergency configuration
  * - [s]  Time to put velocity motor to zero
@@ -191,6 +201,7 @@ typedef struct __attribute__ ((__packed__)) _motor_emergency {
     uint16_t timeout;
 } motor_emergency_t;
 #define LNG_MOTOR_EMERGENCY sizeof(motor_emergency_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_EMERGENCY == 10, motor_emergency_t);
 
 /**
  * Message to define the gains for a PID controller
@@ -210,6 +221,7 @@ typedef struct __attribute__ ((__packed__)) _motor_pid {
     uint8_t enable;
 } motor_pid_t;
 #define LNG_MOTOR_PID sizeof(motor_pid_t)
+WIRE_STATIC_ASSERT(LNG_MOTOR_PID == 21, motor_pid_t);
 /**
  * List of all motor messages
  */
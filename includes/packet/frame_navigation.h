@@ -22,28 +22,34 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+#include "packet/wire.h"
+
 //Name for HASHMAP with information about standard messages
 #define HASHMAP_NAVIGATION 'N'
     
 #define SENSOR_NUMBER_INFRARED 7
 #define SENSOR_BUFFER_AUTOSEND 10
 
-typedef struct _sensor {
+typedef struct __attribute__ ((__packed__)) _sensor {
     float temperature;
     float voltage;
     float current;
 } sensor_t;
 #define LNG_SENSOR sizeof(sensor_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR == 12, sensor_t);
 
 typedef float sensor_humidity_t;
 #define LNG_SENSOR_HUMIDITY sizeof(sensor_humidity_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR_HUMIDITY == 4, sensor_humidity_t);
 
-typedef struct _infrared {
+typedef struct __attribute__ ((__packed__)) _infrared {
     float infrared[SENSOR_NUMBER_INFRARED];
 } sensor_infrared_t;
 #define LNG_SENSOR_INFRARED sizeof(sensor_infrared_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR_INFRARED == 4 * SENSOR_NUMBER_INFRARED, sensor_infrared_t);
 
-typedef struct _sensor_parameter {
+typedef struct __attribute__ ((__packed__)) _sensor_parameter {
     float gain_sharp;
     float exp_sharp;
     float gain_temperature;
@@ -52,14 +58,17 @@ typedef struct _sensor_parameter {
     float gain_humidity;
 } sensor_parameter_t;
 #define LNG_SENSOR_PARAMETER sizeof(sensor_parameter_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR_PARAMETER == 24, sensor_parameter_t);
 
-typedef struct _autosend {
+typedef struct __attribute__ ((__packed__)) _autosend {
     int8_t pkgs[SENSOR_BUFFER_AUTOSEND];
 } sensor_autosend_t;
 #define LNG_SENSOR_AUTOSEND sizeof(sensor_autosend_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR_AUTOSEND == SENSOR_BUFFER_AUTOSEND, sensor_autosend_t);
 
 typedef uint8_t sensor_enable_t;
 #define LNG_SENSOR_ENABLE sizeof(sensor_enable_t)
+WIRE_STATIC_ASSERT(LNG_SENSOR_ENABLE == 1, sensor_enable_t);
 
 
 /**
@@ -23,6 +23,7 @@ extern "C" {
 #endif
     
 #include <stdint.h>
+#include "packet/wire.h"
 
 //Name for HASHMAP with information about standard messages
 #define HASHMAP_PERIPHERALS          'P'
@@ -52,44 +53,54 @@ typedef enum {
  */
 typedef uint8_t peripheral_gpio_number_t;
 #define LNG_PERIPHERAL_GPIO sizeof(peripheral_gpio_number_t)
+WIRE_STATIC_ASSERT(LNG_PERIPHERAL_GPIO == 1, peripheral_gpio_number_t);
 
 /**
  * Value of the pin
  */
 typedef uint16_t peripherals_gpio_t;
-#define LNG_PERIPHERALS_GPIO sizeof(peripherals_gpio_t)  
+#define LNG_PERIPHERALS_GPIO sizeof(peripherals_gpio_t)
+WIRE_STATIC_ASSERT(LNG_PERIPHERALS_GPIO == 2, peripherals_gpio_t);
 
 /**
  * Send the configuration off all digital ports
  * - [#]      Length of the port
  * - [0bXXXX] Binary value of the port
  */
-typedef struct _peripherals_gpio_port {
+typedef struct __attribute__ ((__packed__)) _peripherals_gpio_port {
     uint8_t len;
     peripherals_gpio_t port;
 } peripherals_gpio_port_t;
 #define LNG_PERIPHERALS_GPIO_PORT sizeof(peripherals_gpio_port_t)
+WIRE_STATIC_ASSERT(LNG_PERIPHERALS_GPIO_PORT == 3, peripherals_gpio_port_t);
 
 /**
  * Configuration GPIO
  * - [0bXX...X]  Port GPIO to setup
  * - [0 - 2]     Configuration GPIO [0 Read, 1 Write, 2 Analog (if available)]
+ *               value of peripheral_type_t in a single byte, the size of an
+ *               enum is different on XC16 and on the host
  */
-typedef struct _peripherals_gpio_set {
+typedef struct __attribute__ ((__packed__)) _peripherals_gpio_set {
     peripherals_gpio_port_t port;
-    peripheral_type_t type;
+    uint8_t type;
 } peripherals_gpio_set_t;
 #define LNG_PERIPHERALS_GPIO_SET sizeof(peripherals_gpio_set_t)
+WIRE_STATIC_ASSERT(LNG_PERIPHERALS_GPIO_SET == 4, peripherals_gpio_set_t);
 
 /**
- * 
+ * Configuration serial port
+ * - [#]      Number of the serial port
+ * - [bps]    Baud rate
+ * - [0bXXXX] Configuration of the byte (data bits, parity, stop bits)
  */
-typedef struct _peripherals_serial {
+typedef struct __attribute__ ((__packed__)) _peripherals_serial {
     uint8_t number;
     uint32_t baud;
     int16_t byte_conf;
 } peripherals_serial_t;
 #define LNG_PERIPHERALS_SERIAL sizeof(peripherals_serial_t)
+WIRE_STATIC_ASSERT(LNG_PERIPHERALS_SERIAL == 7, peripherals_serial_t);
 
 /**
  * List of all system messages
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef FRAMEREGISTRY_H
+#define	FRAMEREGISTRY_H
+
+#include "packet/packet.h"
+
+/** Registry of messages
+ * On this header file, we have the list of all messages with the type of
+ * data in tail. The lists are X-macros, to generate tables and code from a
+ * single description of the messages:
+ *      #define X(command, payload, check) ...
+ *      FRAME_REGISTRY_MOTOR(X)
+ * For every message:
+ * * command of message (for motor and peripherals only the command without
+ *   index, see FRAME_COMMAND_MOTOR and FRAME_COMMAND_PERIPHERALS)
+ * * type of data in tail
+ * * check of length of data:
+ *      * FRAME_CHECK_EQUAL length equal to size of data
+ *      * FRAME_CHECK_MAX length lower or equal to size of data
+ */
+
+/*******/
+
+#define FRAME_CHECK_EQUAL 0
+#define FRAME_CHECK_MAX 1
+
+/**
+ * Command without index for motor messages (see motor_command_map_t)
+ * and peripheral messages (see peripheral_gpio_map_t)
+ */
+#define FRAME_COMMAND(command) (command)
+#define FRAME_COMMAND_MOTOR(command) ((unsigned char) (command) >> 3)
+#define FRAME_COMMAND_PERIPHERALS(command) ((unsigned char) (command) & 0x1F)
+
+/**
+ * Command of a message with the index of the motor or the port
+ */
+#define FRAME_INDEX_MOTOR(command, index) ((unsigned char) (((command) << 3) | ((index) & 0x07)))
+#define FRAME_INDEX_PERIPHERALS(command, port) ((unsigned char) (((port) << 5) | ((command) & 0x1F)))
+
+/**
+ * System messages
+ */
+#define FRAME_REGISTRY_SYSTEM(X) \
+    X(SYSTEM_RESET,                     uint8_t,                            FRAME_CHECK_MAX) \
+    X(SYSTEM_CODE_DATE,                 system_service_t,                   FRAME_CHECK_MAX) \
+    X(SYSTEM_CODE_VERSION,              system_service_t,                   FRAME_CHECK_MAX) \
+    X(SYSTEM_CODE_AUTHOR,               system_service_t,                   FRAME_CHECK_MAX) \
+    X(SYSTEM_CODE_BOARD_TYPE,           system_service_t,                   FRAME_CHECK_MAX) \
+    X(SYSTEM_CODE_BOARD_NAME,           system_service_t,                   FRAME_CHECK_MAX) \
+    X(SYSTEM_SERIAL_ERROR,              system_error_serial_t,              FRAME_CHECK_EQUAL) \
+    X(SYSTEM_TIME,                      system_time_t,                      FRAME_CHECK_EQUAL) \
+    X(SYSTEM_CAPABILITY,                system_capability_t,                FRAME_CHECK_EQUAL) \
+    X(SYSTEM_MODE,                      system_mode_t,                      FRAME_CHECK_EQUAL)
+
+/**
+ * Motor messages
+ */
+#define FRAME_REGISTRY_MOTOR(X) \
+    X(MOTOR_MEASURE,                    motor_t,                            FRAME_CHECK_EQUAL) \
+    X(MOTOR_REFERENCE,                  motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_CONTROL,                    motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_DIAGNOSTIC,                 motor_diagnostic_t,                 FRAME_CHECK_EQUAL) \
+    X(MOTOR_PARAMETER,                  motor_parameter_t,                  FRAME_CHECK_EQUAL) \
+    X(MOTOR_CONSTRAINT,                 motor_t,                            FRAME_CHECK_EQUAL) \
+    X(MOTOR_EMERGENCY,                  motor_emergency_t,                  FRAME_CHECK_EQUAL) \
+    X(MOTOR_STATE,                      motor_state_t,                      FRAME_CHECK_EQUAL) \
+    X(MOTOR_POS_RESET,                  motor_control_t,                    FRAME_CHECK_MAX) \
+    X(MOTOR_POS_PID,                    motor_pid_t,                        FRAME_CHECK_EQUAL) \
+    X(MOTOR_POS_REF,                    motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_VEL_PID,                    motor_pid_t,                        FRAME_CHECK_EQUAL) \
+    X(MOTOR_VEL_REF,                    motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_CURRENT_PID,                motor_pid_t,                        FRAME_CHECK_EQUAL) \
+    X(MOTOR_CURRENT_REF,                motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_TORQUE_REF,                 motor_control_t,                    FRAME_CHECK_EQUAL) \
+    X(MOTOR_SAFETY,                     motor_safety_t,                     FRAME_CHECK_EQUAL)
+
+/**
+ * Differential drive messages
+ */
+#define FRAME_REGISTRY_DIFF_DRIVE(X) \
+    X(DIFF_DRIVE_COORDINATE,            diff_drive_coordinate_t,            FRAME_CHECK_EQUAL) \
+    X(DIFF_DRIVE_VEL,                   diff_drive_velocity_t,              FRAME_CHECK_EQUAL) \
+    X(DIFF_DRIVE_PARAMETER_UNICYCLE,    diff_drive_parameter_unicycle_t,    FRAME_CHECK_EQUAL) \
+    X(DIFF_DRIVE_STATE,                 diff_drive_state_t,                 FRAME_CHECK_EQUAL) \
+    X(DIFF_DRIVE_VEL_REF,               diff_drive_velocity_t,              FRAME_CHECK_EQUAL)
+
+/**
+ * Navigation messages
+ */
+#define FRAME_REGISTRY_NAVIGATION(X) \
+    X(SENSOR,                           sensor_t,                           FRAME_CHECK_EQUAL) \
+    X(SENSOR_INFRARED,                  sensor_infrared_t,                  FRAME_CHECK_EQUAL) \
+    X(SENSOR_HUMIDITY,                  sensor_humidity_t,                  FRAME_CHECK_EQUAL) \
+    X(SENSOR_PARAMETER,                 sensor_parameter_t,                 FRAME_CHECK_EQUAL) \
+    X(SENSOR_AUTOSEND,                  sensor_autosend_t,                  FRAME_CHECK_EQUAL) \
+    X(SENSOR_ENABLE,                    sensor_enable_t,                    FRAME_CHECK_EQUAL)
+
+/**
+ * Peripherals messages
+ */
+#define FRAME_REGISTRY_PERIPHERALS(X) \
+    X(PERIPHERALS_GPIO,                 peripherals_gpio_port_t,            FRAME_CHECK_MAX) \
+    X(PERIPHERALS_GPIO_SET,             peripherals_gpio_set_t,             FRAME_CHECK_EQUAL) \
+    X(PERIPHERALS_GPIO_DIGITAL,         peripherals_gpio_port_t,            FRAME_CHECK_MAX) \
+    X(PERIPHERALS_SERIAL,               peripherals_serial_t,               FRAME_CHECK_EQUAL)
+
+/**
+ * Block transfer messages
+ */
+#define FRAME_REGISTRY_BLOCK(X) \
+    X(BLOCK_STATE,                      block_state_t,                      FRAME_CHECK_EQUAL) \
+    X(BLOCK_CHUNK,                      block_chunk_t,                      FRAME_CHECK_MAX) \
+    X(BLOCK_CHECK,                      block_check_t,                      FRAME_CHECK_EQUAL)
+
+/**
+ * Families in use (see packet/frame_config.h)
+ */
+#if FRAME_SYSTEM
+#define FRAME_REGISTRY_FAMILY_SYSTEM(X) X(HASHMAP_SYSTEM, FRAME_REGISTRY_SYSTEM, FRAME_COMMAND)
+#else
+#define FRAME_REGISTRY_FAMILY_SYSTEM(X)
+#endif
+#if FRAME_MOTOR
+#define FRAME_REGISTRY_FAMILY_MOTOR(X) X(HASHMAP_MOTOR, FRAME_REGISTRY_MOTOR, FRAME_COMMAND_MOTOR)
+#else
+#define FRAME_REGISTRY_FAMILY_MOTOR(X)
+#endif
+#if FRAME_DIFF_DRIVE
+#define FRAME_REGISTRY_FAMILY_DIFF_DRIVE(X) X(HASHMAP_DIFF_DRIVE, FRAME_REGISTRY_DIFF_DRIVE, FRAME_COMMAND)
+#else
+#define FRAME_REGISTRY_FAMILY_DIFF_DRIVE(X)
+#endif
+#if FRAME_NAVIGATION
+#define FRAME_REGISTRY_FAMILY_NAVIGATION(X) X(HASHMAP_NAVIGATION, FRAME_REGISTRY_NAVIGATION, FRAME_COMMAND)
+#else
+#define FRAME_REGISTRY_FAMILY_NAVIGATION(X)
+#endif
+#if FRAME_PERIPHERALS
+#define FRAME_REGISTRY_FAMILY_PERIPHERALS(X) X(HASHMAP_PERIPHERALS, FRAME_REGISTRY_PERIPHERALS, FRAME_COMMAND_PERIPHERALS)
+#else
+#define FRAME_REGISTRY_FAMILY_PERIPHERALS(X)
+#endif
+#if FRAME_BLOCK
+#define FRAME_REGISTRY_FAMILY_BLOCK(X) X(HASHMAP_BLOCK, FRAME_REGISTRY_BLOCK, FRAME_COMMAND)
+#else
+#define FRAME_REGISTRY_FAMILY_BLOCK(X)
+#endif
+
+/**
+ * List of all families of messages in use:
+ * * type of messages (name of hashmap)
+ * * list of messages
+ * * function to get the command without index
+ *      #define X(type, messages, command) ...
+ *      FRAME_REGISTRY(X)
+ */
+#define FRAME_REGISTRY(X) \
+    FRAME_REGISTRY_FAMILY_SYSTEM(X) \
+    FRAME_REGISTRY_FAMILY_MOTOR(X) \
+    FRAME_REGISTRY_FAMILY_DIFF_DRIVE(X) \
+    FRAME_REGISTRY_FAMILY_NAVIGATION(X) \
+    FRAME_REGISTRY_FAMILY_PERIPHERALS(X) \
+    FRAME_REGISTRY_FAMILY_BLOCK(X)
+
+#endif	/* FRAMEREGISTRY_H */
@@ -22,6 +22,9 @@
 extern "C" {
 #endif
     
+#include <stdint.h>
+#include "packet/wire.h"
+
 //Name for HASHMAP with information about standard messages
 #define HASHMAP_SYSTEM          'S'
     
@@ -38,6 +41,7 @@ extern "C" {
  */
 typedef unsigned char system_service_t[MAX_BUFF_SERVICE];
 #define LNG_SYSTEM_SERVICE sizeof(system_service_t)
+WIRE_STATIC_ASSERT(LNG_SYSTEM_SERVICE == MAX_BUFF_SERVICE, system_service_t);
 
 /**
  * Service messages about number of error on serial communication
@@ -45,6 +49,7 @@ typedef unsigned char system_service_t[MAX_BUFF_SERVICE];
  */
 typedef int16_t system_error_serial_t[MAX_BUFF_ERROR_SERIAL];
 #define LNG_SYSTEM_ERROR_SERIAL sizeof(system_error_serial_t)
+WIRE_STATIC_ASSERT(LNG_SYSTEM_ERROR_SERIAL == 2 * MAX_BUFF_ERROR_SERIAL, system_error_serial_t);
 
 /**
  * - [#]   Time in idle
@@ -61,6 +66,60 @@ typedef struct __attribute__ ((__packed__)) _system_events {
     uint32_t i2c;
 } system_time_t;
 #define LNG_SYSTEM_TIME sizeof(system_time_t)
+WIRE_STATIC_ASSERT(LNG_SYSTEM_TIME == 20, system_time_t);
+
+/**
+ * Capability of a board, requested from the host at connect time:
+ * - [#] version of protocol (SYSTEM_PROTOCOL_VERSION)
+ * - [B] max length of data in a frame
+ * - [#] integrity modes supported (mask of SYSTEM_INTEGRITY_*)
+ * - [#] framing modes supported (mask of SYSTEM_FRAMING_*)
+ * - [#] features supported (mask of SYSTEM_FEATURE_*)
+ */
+typedef struct __attribute__ ((__packed__)) _system_capability {
+    uint8_t version;
+    uint8_t frame;
+    uint8_t integrity;
+    uint8_t framing;
+    uint8_t features;
+} system_capability_t;
+#define LNG_SYSTEM_CAPABILITY sizeof(system_capability_t)
+WIRE_STATIC_ASSERT(LNG_SYSTEM_CAPABILITY == 5, system_capability_t);
+
+/**
+ * Mode of the link, one integrity mode and one framing mode. The board
+ * replies ACK in the old mode and uses the new mode from the next frame.
+ */
+typedef struct __attribute__ ((__packed__)) _system_mode {
+    uint8_t integrity;
+    uint8_t framing;
+} system_mode_t;
+#define LNG_SYSTEM_MODE sizeof(system_mode_t)
+WIRE_STATIC_ASSERT(LNG_SYSTEM_MODE == 2, system_mode_t);
+
+// Version of protocol
+#define SYSTEM_PROTOCOL_VERSION 1
+/** Integrity modes, check in tail of the frame */
+// Sum of data, 1 byte (default)
+#define SYSTEM_INTEGRITY_SUM    0x01
+// CRC16 CCITT of data, 2 bytes (MSB first)
+#define SYSTEM_INTEGRITY_CRC16  0x02
+// Without check, only for links with their check (UDP, UNIX sockets)
+#define SYSTEM_INTEGRITY_NONE   0x04
+/** Framing modes */
+// Header and length of data (default)
+#define SYSTEM_FRAMING_HEADER   0x01
+/** Features */
+// Messages with sequence number (Q)
+#define SYSTEM_FEATURE_SEQUENCE     0x01
+// Patch of messages (P)
+#define SYSTEM_FEATURE_PATCH        0x02
+// Deferred replies
+#define SYSTEM_FEATURE_DEFERRED     0x04
+// Compressed messages
+#define SYSTEM_FEATURE_COMPRESSION  0x08
+// Messages sent from the board without request
+#define SYSTEM_FEATURE_SUBSCRIPTION 0x10
 
 // TO BE CHECK =========================================
     
@@ -94,6 +153,8 @@ typedef union _system_frame {
     system_service_t service;
     system_error_serial_t error_serial;
     system_time_t time;
+    system_capability_t capability;
+    system_mode_t mode;
 } system_frame_u;
 
 //Number association for standard messages
@@ -105,6 +166,8 @@ typedef union _system_frame {
 #define SYSTEM_CODE_BOARD_NAME 'n'
 #define SYSTEM_SERIAL_ERROR     0
 #define SYSTEM_TIME             1
+#define SYSTEM_CAPABILITY       2
+#define SYSTEM_MODE             3
 
 #ifdef	__cplusplus
 }
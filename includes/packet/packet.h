@@ -19,6 +19,8 @@
 #define	PACKET_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "packet/wire.h"
 
 /** Serial packets
  * On this header file, we have all definition about communication and defined
@@ -39,11 +41,23 @@
 
 /*******/
 
+#include "packet/frame_config.h"
+#include "packet/frame_system.h"
+#if FRAME_DIFF_DRIVE
 #include "packet/frame_diff_drive.h"
+#endif
+#if FRAME_MOTOR
 #include "packet/frame_motor.h"
-#include "packet/frame_system.h"
+#endif
+#if FRAME_NAVIGATION
 #include "packet/frame_navigation.h"
+#endif
+#if FRAME_PERIPHERALS
 #include "packet/frame_peripherals.h"
+#endif
+#if FRAME_BLOCK
+#include "packet/frame_block.h"
+#endif
 
 /// Header packet
 #define PACKET_HEADER '#'
@@ -67,6 +81,13 @@
 #define PACKET_NACK     'N'
 // Empty packet
 #define PACKET_EMPTY    'E'
+// Patch a sub-range of a message
+#define PACKET_PATCH    'P'
+// Messages with data and a sequence number in the last byte. The ACK or NACK
+// replies have the same sequence number as data.
+#define PACKET_DATA_SEQ 'Q'
+// Length of sequence number
+#define LNG_PACKET_SEQUENCE 1
 // Length of information packet (without data)
 #define LNG_HEAD_INFORMATION_PACKET 4
 
@@ -84,14 +105,49 @@
  */
 
 /**
- * Union for conversion all type of packets in a standard packets
+ * Message to write only a sub-range of a message (P):
+ * - [#] offset of the first byte to write inside the message
+ * - [#] number of bytes to write
+ * - [#] bytes to write
+ * The board reads the current message, applies the patch and writes back
+ * the whole message. Offset and length are validated against the size of
+ * the message returned from the board.
+ */
+#define MAX_BUFF_PATCH 16
+typedef struct __attribute__ ((__packed__)) _message_patch {
+    uint8_t offset;
+    uint8_t length;
+    uint8_t data[MAX_BUFF_PATCH];
+} message_patch_t;
+// Length of patch message (without data)
+#define LNG_HEAD_MESSAGE_PATCH 2
+#define LNG_MESSAGE_PATCH(len) (LNG_HEAD_MESSAGE_PATCH + (len))
+WIRE_STATIC_ASSERT(sizeof(message_patch_t) == LNG_MESSAGE_PATCH(MAX_BUFF_PATCH), message_patch_t);
+
+/**
+ * Union for conversion all type of packets in a standard packets, only
+ * with the families in use (see packet/frame_config.h)
  */
 typedef union _message_abstract {
+#if FRAME_SYSTEM
     system_frame_u system;
+#endif
+#if FRAME_MOTOR
     motor_frame_u motor;
+#endif
+#if FRAME_DIFF_DRIVE
     diff_drive_frame_u diff_drive;
+#endif
+#if FRAME_NAVIGATION
     navigation_frame_u sensor;
+#endif
+#if FRAME_PERIPHERALS
     peripherals_gpio_frame_u gpio;
+#endif
+#if FRAME_BLOCK
+    block_frame_u block;
+#endif
+    message_patch_t patch;
 } message_abstract_u;
 
 /**
@@ -102,6 +158,8 @@ typedef union _message_abstract {
  *      * (D) Packet with data
  *      * (K) ACK
  *      * (N) NACK
+ *      * (P) Patch of a message
+ *      * (Q) Packet with data and sequence number
  * * type packet:
  *      * (D) Default messages (in top on this file)
  *      * other type messages (in UNAV file)
@@ -114,6 +172,7 @@ typedef struct _packet_information {
     unsigned char command;
     message_abstract_u message;
 } packet_information_t;
+WIRE_STATIC_ASSERT(offsetof(packet_information_t, message) == LNG_HEAD_INFORMATION_PACKET, packet_information_t);
 
 /**
  * Union to quickly transform information_packet_t in a buffer to add in
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef WIRE_H
+#define	WIRE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/** Wire layout
+ * All messages are sent on the bus with the same layout on the board
+ * (XC16) and on the host (gcc x86, ARM):
+ * * packed structures (no padding), with fixed width types
+ * * little endian numbers, IEEE 754 single precision float
+ * The size of all messages is verified at compile time with
+ * WIRE_STATIC_ASSERT, then a host little endian can read the messages
+ * directly from the buffer received. A host big endian must use the
+ * accessors wire_get_* and wire_set_*.
+ */
+
+/*******/
+
+/**
+ * Compile time check, the build fails if cond is false
+ */
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define WIRE_STATIC_ASSERT(cond, name) static_assert(cond, #name)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define WIRE_STATIC_ASSERT(cond, name) _Static_assert(cond, #name)
+#else
+#define WIRE_STATIC_ASSERT(cond, name) typedef char wire_assert_##name[(cond) ? 1 : -1]
+#endif
+
+/**
+ * Byte order of this machine
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define WIRE_BIG_ENDIAN 1
+#else
+#define WIRE_BIG_ENDIAN 0
+#endif
+
+WIRE_STATIC_ASSERT(sizeof(float) == 4, wire_float);
+
+/**
+ * Read and write little endian numbers at any address in a buffer
+ */
+static inline uint16_t wire_get_uint16(const void* buffer) {
+    const uint8_t* data = (const uint8_t*) buffer;
+    return (uint16_t) data[0] | ((uint16_t) data[1] << 8);
+}
+
+static inline uint32_t wire_get_uint32(const void* buffer) {
+    const uint8_t* data = (const uint8_t*) buffer;
+    return (uint32_t) data[0] | ((uint32_t) data[1] << 8)
+            | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static inline float wire_get_float(const void* buffer) {
+    uint32_t value = wire_get_uint32(buffer);
+    float number;
+    memcpy(&number, &value, sizeof(number));
+    return number;
+}
+
+static inline void wire_set_uint16(void* buffer, uint16_t value) {
+    uint8_t* data = (uint8_t*) buffer;
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+static inline void wire_set_uint32(void* buffer, uint32_t value) {
+    uint8_t* data = (uint8_t*) buffer;
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = value >> 24;
+}
+
+static inline void wire_set_float(void* buffer, float number) {
+    uint32_t value;
+    memcpy(&value, &number, sizeof(value));
+    wire_set_uint32(buffer, value);
+}
+
+#endif	/* WIRE_H */
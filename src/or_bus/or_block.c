@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_bus/or_frame.h"
+#include "or_bus/or_message.h"
+#include "or_bus/or_block.h"
+
+#if FRAME_BLOCK
+
+/**
+ * Area for block transfer:
+ * - size of the area
+ * - functions to read and write the area
+ * - offset of data verified
+ */
+typedef struct _block_area {
+    uint32_t size;
+    block_read_t read;
+    block_write_t write;
+    uint32_t offset;
+} block_area_t;
+
+block_area_t block_area[BLOCK_AREAS];
+
+/**
+ * Transfer in progress:
+ * - area selected
+ * - end of data to write
+ * - offset of the next chunk
+ * - CRC16 of the chunks after the offset verified
+ */
+typedef struct _block_transfer {
+    unsigned char area;
+    uint32_t end;
+    uint32_t received;
+    uint16_t crc;
+} block_transfer_t;
+
+block_transfer_t block_transfer;
+
+/******************************************************************************/
+/* Block transfer functions                                                   */
+/******************************************************************************/
+
+/**
+ * Create the message with the state of an area.
+ */
+packet_information_t block_state(unsigned char area, uint32_t size) {
+    message_abstract_u message;
+    message.block.state.area = area;
+    message.block.state.size = size;
+    message.block.state.offset = block_area[area].offset;
+    return createPacket(BLOCK_STATE, PACKET_DATA, HASHMAP_BLOCK, &message, LNG_BLOCK_STATE);
+}
+
+/**
+ * Restart the chunks from the offset verified.
+ */
+void block_restart() {
+    block_transfer.received = block_area[block_transfer.area].offset;
+    block_transfer.crc = orb_integrity_init(SYSTEM_INTEGRITY_CRC16);
+}
+
+/**
+ * Request of the state of an area, the area is selected for the read.
+ */
+packet_information_t block_state_send(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    unsigned char area = message->block.state.area;
+    if(area >= BLOCK_AREAS || block_area[area].size == 0) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    block_transfer.area = area;
+    block_transfer.end = 0;
+    return block_state(area, block_area[area].size);
+}
+
+/**
+ * Start or resume the write of an area.
+ */
+packet_information_t block_state_receive(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    block_state_t* state = &message->block.state;
+    block_area_t* area;
+    if(state->area >= BLOCK_AREAS) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    area = &block_area[state->area];
+    if(area->write == NULL || state->size > area->size || state->offset > area->offset
+            || state->offset > state->size) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    area->offset = state->offset;
+    block_transfer.area = state->area;
+    block_transfer.end = state->size;
+    block_restart();
+    return block_state(state->area, state->size);
+}
+
+/**
+ * Request of a chunk of the area selected.
+ */
+packet_information_t block_chunk_send(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    block_chunk_t* chunk = &message->block.chunk;
+    block_area_t* area;
+    if(block_transfer.area == BLOCK_NONE) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    area = &block_area[block_transfer.area];
+    if(area->read == NULL || chunk->length == 0 || chunk->length > MAX_BUFF_BLOCK_CHUNK
+            || chunk->offset > area->size || chunk->length > area->size - chunk->offset
+            || !area->read(chunk->offset, chunk->data, chunk->length)) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    return createPacket(BLOCK_CHUNK, PACKET_DATA, HASHMAP_BLOCK, message, LNG_HEAD_BLOCK_CHUNK + chunk->length);
+}
+
+/**
+ * Write a chunk, only the next chunk of the transfer is written. The other
+ * chunks are dropped and the check of the block fails.
+ */
+packet_information_t block_chunk_receive(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    block_chunk_t* chunk = &message->block.chunk;
+    if(block_transfer.area != BLOCK_NONE && block_transfer.end != 0
+            && chunk->offset == block_transfer.received
+            && chunk->length != 0 && chunk->length <= MAX_BUFF_BLOCK_CHUNK
+            && chunk->length <= block_transfer.end - chunk->offset
+            && block_area[block_transfer.area].write(chunk->offset, chunk->data, chunk->length)) {
+        block_transfer.received += chunk->length;
+        block_transfer.crc = orb_integrity_update(SYSTEM_INTEGRITY_CRC16, block_transfer.crc, chunk->data, chunk->length);
+    }
+    return CREATE_PACKET_EMPTY;
+}
+
+/**
+ * Request of the check of data in the area selected.
+ */
+packet_information_t block_check_send(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    block_check_t* check = &message->block.check;
+    unsigned char data[MAX_BUFF_BLOCK_CHUNK];
+    uint16_t crc = orb_integrity_init(SYSTEM_INTEGRITY_CRC16);
+    uint32_t offset = check->offset, end;
+    block_area_t* area;
+    if(block_transfer.area == BLOCK_NONE) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    area = &block_area[block_transfer.area];
+    if(area->read == NULL || check->offset > area->size || check->length > area->size - check->offset) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    end = check->offset + check->length;
+    while(offset < end) {
+        unsigned int length = (end - offset < MAX_BUFF_BLOCK_CHUNK) ? end - offset : MAX_BUFF_BLOCK_CHUNK;
+        if(!area->read(offset, data, length)) {
+            return CREATE_PACKET_NACK(command, type);
+        }
+        crc = orb_integrity_update(SYSTEM_INTEGRITY_CRC16, crc, data, length);
+        offset += length;
+    }
+    check->crc = crc;
+    return createPacket(BLOCK_CHECK, PACKET_DATA, HASHMAP_BLOCK, message, LNG_BLOCK_CHECK);
+}
+
+/**
+ * Verify a block of the transfer, the reply is the state of the transfer.
+ * A block already verified (the previous reply is lost) is not verified
+ * again.
+ */
+packet_information_t block_check_receive(unsigned char option, unsigned char type, unsigned char command, message_abstract_u* message) {
+    block_check_t* check = &message->block.check;
+    block_area_t* area;
+    if(block_transfer.area == BLOCK_NONE || block_transfer.end == 0) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    area = &block_area[block_transfer.area];
+    if(check->offset == area->offset && check->length == block_transfer.received - area->offset
+            && check->crc == block_transfer.crc) {
+        area->offset = block_transfer.received;
+    }
+    block_restart();
+    return block_state(block_transfer.area, block_transfer.end);
+}
+
+void orb_block_init() {
+    unsigned short i;
+    for(i = 0; i < BLOCK_AREAS; ++i) {
+        block_area[i].size = 0;
+        block_area[i].read = NULL;
+        block_area[i].write = NULL;
+        block_area[i].offset = 0;
+    }
+    block_transfer.area = BLOCK_NONE;
+    block_transfer.end = 0;
+    set_message_reader(REGISTRY_BLOCK_STATE, block_state_send, block_state_receive);
+    set_message_reader(REGISTRY_BLOCK_CHUNK, block_chunk_send, block_chunk_receive);
+    set_message_reader(REGISTRY_BLOCK_CHECK, block_check_send, block_check_receive);
+}
+
+bool orb_block_area(unsigned char area, uint32_t size, block_read_t read, block_write_t write) {
+    if(area >= BLOCK_AREAS) {
+        return false;
+    }
+    block_area[area].size = size;
+    block_area[area].read = read;
+    block_area[area].write = write;
+    block_area[area].offset = 0;
+    return true;
+}
+
+#endif
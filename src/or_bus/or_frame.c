@@ -26,7 +26,9 @@
 #include "or_bus/or_frame.h"
 #include "or_bus/or_message.h"
 
-#define HASHMAP_NUMBER 4
+#ifndef HASHMAP_NUMBER
+#define HASHMAP_NUMBER FRAME_FAMILIES
+#endif
 
 typedef struct _frame_read {
     frame_reader_t send;
@@ -41,6 +43,59 @@ typedef struct _hashmap {
 hashmap hash[HASHMAP_NUMBER];
 unsigned short counter = 0;
 
+typedef struct _message_read {
+    message_reader_t send;
+    message_reader_t receive;
+} message_read_t;
+
+message_read_t message_reader[REGISTRY_NUMBER];
+
+#define DEFERRED_FREE 0
+#define DEFERRED_PENDING 1
+#define DEFERRED_READY 2
+
+typedef struct _deferred {
+    volatile unsigned char state;
+    int sequence;
+    packet_information_t reply;
+} deferred_t;
+
+deferred_t deferred[BUFFER_LIST_DEFERRED];
+
+typedef struct _cache {
+    unsigned char type;
+    unsigned char command;
+    bool valid;
+    volatile bool dirty;
+    packet_information_t reply;
+} cache_t;
+
+cache_t cache[BUFFER_LIST_CACHE];
+unsigned short cache_counter = 0;
+
+/*! Packet in parsing and index of the next message */
+packet_t* parser_receive = NULL;
+unsigned int parser_index = 0;
+/*! Sequence number of the message in parsing */
+#define SEQUENCE_NONE -1
+int parser_sequence = SEQUENCE_NONE;
+
+/*! Output of the parser: a list of messages or a packet to send */
+typedef struct _parser_output {
+    packet_information_t* list;
+    size_t* len;
+    size_t size;
+    packet_t* packet;
+} parser_output_t;
+
+parser_output_t parser_output = {NULL, NULL, 0, NULL};
+
+/*! Features of the parser, the board adds its features */
+#define PARSER_FEATURES (SYSTEM_FEATURE_SEQUENCE | SYSTEM_FEATURE_PATCH | SYSTEM_FEATURE_DEFERRED)
+unsigned char parser_features = PARSER_FEATURES;
+
+size_t deferred_flush();
+
 /******************************************************************************/
 /* Parsing functions                                                          */
 /******************************************************************************/
@@ -52,6 +107,19 @@ void orb_frame_init() {
         hash[i].reader.receive = NULL;
         hash[i].name = 0;
     }
+    for(i = 0; i < BUFFER_LIST_DEFERRED; ++i) {
+        deferred[i].state = DEFERRED_FREE;
+    }
+    for(i = 0; i < REGISTRY_NUMBER; ++i) {
+        message_reader[i].send = NULL;
+        message_reader[i].receive = NULL;
+    }
+    cache_counter = 0;
+    parser_features = PARSER_FEATURES;
+}
+
+void orb_frame_features(unsigned char features) {
+    parser_features |= features;
 }
 
 void set_frame_reader(unsigned char hashmap, frame_reader_t send, frame_reader_t receive) {
@@ -59,11 +127,21 @@ void set_frame_reader(unsigned char hashmap, frame_reader_t send, frame_reader_t
     frame.send = send;
     frame.receive = receive;
     
+    if(counter >= HASHMAP_NUMBER) {
+        return;
+    }
     hash[counter].name = hashmap;
     hash[counter].reader = frame;
     counter++;
 }
 
+void set_message_reader(int index, message_reader_t send, message_reader_t receive) {
+    if(index >= 0 && index < REGISTRY_NUMBER) {
+        message_reader[index].send = send;
+        message_reader[index].receive = receive;
+    }
+}
+
 int get_key(unsigned char hashmap) {
     int i;
     for(i = 0; i < HASHMAP_NUMBER; ++i) {
@@ -74,43 +152,476 @@ int get_key(unsigned char hashmap) {
     return -1;
 }
 
-bool parser(packet_t* receive_pkg, packet_information_t* list_to_send, size_t* len) {
-    unsigned int i;
+/**
+ * Call the reader for a message: the message reader registered for the
+ * command or, if not registered, the frame reader of the type.
+ * @param key index of the hashmap or -1
+ * @param index index of the message in registry or REGISTRY_UNKNOWN
+ * @param option PACKET_REQUEST for the send reader, PACKET_DATA for the
+ * receive reader
+ * @param info message received
+ * @return packet returned from the reader or an empty packet if there is
+ * not any reader
+ */
+packet_information_t parser_read(int key, int index, unsigned char option, packet_information_t* info) {
+    if(option == PACKET_REQUEST) {
+        if(index != REGISTRY_UNKNOWN && message_reader[index].send != NULL) {
+            return message_reader[index].send(option, info->type, info->command, &info->message);
+        }
+        if(key != -1 && hash[key].reader.send != NULL) {
+            return hash[key].reader.send(option, info->type, info->command, info->message);
+        }
+    } else {
+        if(index != REGISTRY_UNKNOWN && message_reader[index].receive != NULL) {
+            return message_reader[index].receive(option, info->type, info->command, &info->message);
+        }
+        if(key != -1 && hash[key].reader.receive != NULL) {
+            return hash[key].reader.receive(option, info->type, info->command, info->message);
+        }
+    }
+    return CREATE_PACKET_EMPTY;
+}
+
+/**
+ * Apply a patch (P) on a message. The current value of the message is read
+ * with the send reader, the patch is validated against the length of this
+ * message and the patched message is written with the receive reader.
+ * @param key index of the hashmap or -1
+ * @param index index of the message in registry or REGISTRY_UNKNOWN
+ * @param info patch message received
+ * @return packet returned from receive reader or a NACK message
+ */
+packet_information_t parser_patch(int key, int index, packet_information_t* info) {
+    packet_information_t current;
+    message_patch_t* patch = &info->message.patch;
+    // The patch must contain all bytes declared
+    if(patch->length == 0 || patch->length > MAX_BUFF_PATCH
+            || info->length < LNG_HEAD_INFORMATION_PACKET + LNG_MESSAGE_PATCH(patch->length)) {
+        return CREATE_PACKET_NACK(info->command, info->type);
+    }
+    // Read the current value of the message
+    current = parser_read(key, index, PACKET_REQUEST, info);
+    if(current.option != PACKET_DATA) {
+        return CREATE_PACKET_NACK(info->command, info->type);
+    }
+    // Validate the patch against the size of the message
+    if(patch->offset + patch->length > current.length - LNG_HEAD_INFORMATION_PACKET) {
+        return CREATE_PACKET_NACK(info->command, info->type);
+    }
+    memcpy(((unsigned char*) &current.message) + patch->offset, patch->data, patch->length);
+    current.option = PACKET_DATA;
+    current.type = info->type;
+    current.command = info->command;
+    current = parser_read(key, index, PACKET_DATA, &current);
+    if(current.option == PACKET_EMPTY) {
+        return CREATE_PACKET_NACK(info->command, info->type);
+    }
+    return current;
+}
+
+/**
+ * Find the reply in cache for a message.
+ * @return the reply in cache or NULL if the message is not registered
+ */
+cache_t* cache_find(unsigned char type, unsigned char command) {
+    unsigned short i;
+    for(i = 0; i < cache_counter; ++i) {
+        if(cache[i].type == type && cache[i].command == command) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Reply to a request (R), from the cache if the reply is not dirty.
+ * @param reply buffer for the reply if it is not in cache
+ * @return the reply in cache or reply
+ */
+packet_information_t* parser_request(int key, int index, packet_information_t* info, packet_information_t* reply) {
+    cache_t* entry = cache_find(info->type, info->command);
+    if(entry == NULL) {
+        *reply = parser_read(key, index, PACKET_REQUEST, info);
+        return reply;
+    }
+    if(entry->valid && !entry->dirty) {
+        return &entry->reply;
+    }
+    // If the message change during the reader, the reply stay dirty
+    entry->dirty = false;
+    *reply = parser_read(key, index, PACKET_REQUEST, info);
+    entry->valid = (reply->option == PACKET_DATA);
+    if(entry->valid) {
+        memcpy(&entry->reply, reply, reply->length);
+    }
+    return reply;
+}
+
+#if FRAME_SYSTEM
+/**
+ * Reply to the messages for the protocol: capability of the board (only
+ * request) and mode of the link. The new mode is used after the frame with
+ * the ACK (see orb_message_mode).
+ * @param index index of the message in registry
+ * @param info message received
+ * @return reply to the message
+ */
+packet_information_t parser_protocol(int index, packet_information_t* info) {
+    message_abstract_u message;
+    if(info->option == PACKET_REQUEST) {
+        if(index == REGISTRY_SYSTEM_CAPABILITY) {
+            message.system.capability.version = SYSTEM_PROTOCOL_VERSION;
+            message.system.capability.frame = MAX_BUFF_RX;
+            message.system.capability.integrity = orb_message_modes();
+            message.system.capability.framing = SYSTEM_FRAMING_HEADER;
+            message.system.capability.features = parser_features;
+            return createPacket(SYSTEM_CAPABILITY, PACKET_DATA, HASHMAP_SYSTEM, &message, LNG_SYSTEM_CAPABILITY);
+        }
+        message.system.mode.integrity = orb_message_integrity();
+        message.system.mode.framing = SYSTEM_FRAMING_HEADER;
+        return createPacket(SYSTEM_MODE, PACKET_DATA, HASHMAP_SYSTEM, &message, LNG_SYSTEM_MODE);
+    }
+    if(info->option == PACKET_DATA && index == REGISTRY_SYSTEM_MODE
+            && orb_registry_check(index, info->length - LNG_HEAD_INFORMATION_PACKET)
+            && info->message.system.mode.framing == SYSTEM_FRAMING_HEADER
+            && orb_message_mode(info->message.system.mode.integrity)) {
+        return CREATE_PACKET_ACK(info->command, info->type);
+    }
+    return CREATE_PACKET_NACK(info->command, info->type);
+}
+#endif
+
+/**
+ * Check if a reply must have in tail the sequence number of a (Q) message.
+ */
+bool parser_sequence_check(const packet_information_t* packet, int sequence) {
+    return sequence != SEQUENCE_NONE && packet->length == LNG_HEAD_INFORMATION_PACKET
+            && (packet->option == PACKET_ACK || packet->option == PACKET_NACK);
+}
+
+/**
+ * Add the sequence number of a (Q) message in the ACK or NACK reply.
+ */
+void parser_sequence_reply(packet_information_t* packet, int sequence) {
+    if(parser_sequence_check(packet, sequence)) {
+        ((unsigned char*) &packet->message)[0] = sequence;
+        packet->length += LNG_PACKET_SEQUENCE;
+    }
+}
+
+/**
+ * Write a reply in the output of the parser: in the list of messages or back
+ * to back in the packet to send, with the sequence number of the message in
+ * parsing.
+ * @return false if there is not space for the reply
+ */
+bool parser_write(const packet_information_t* packet, int sequence) {
+    bool tail = parser_sequence_check(packet, sequence);
+    unsigned int length = packet->length + (tail ? LNG_PACKET_SEQUENCE : 0);
+    if(parser_output.packet != NULL) {
+        packet_t* send = parser_output.packet;
+        if(send->length + length > MAX_BUFF_TX) {
+            return false;
+        }
+        memcpy(&send->buffer[send->length], packet, packet->length);
+        if(tail) {
+            send->buffer[send->length] = length;
+            send->buffer[send->length + packet->length] = sequence;
+        }
+        send->length += length;
+    } else {
+        if(*parser_output.len >= parser_output.size) {
+            return false;
+        }
+        memcpy(&parser_output.list[*parser_output.len], packet, packet->length);
+        parser_sequence_reply(&parser_output.list[*parser_output.len], sequence);
+        (*parser_output.len)++;
+    }
+    return true;
+}
+
+/**
+ * Check if the output of the parser has space for the largest reply.
+ */
+bool parser_space() {
+    if(parser_output.packet != NULL) {
+        return parser_output.packet->length + sizeof(packet_information_t) <= MAX_BUFF_TX;
+    }
+    return *parser_output.len < parser_output.size;
+}
+
+/**
+ * Append a reply in the output of the parser. Empty and deferred replies
+ * are not sent.
+ */
+void parser_append(const packet_information_t* packet) {
+    if(packet->option != PACKET_EMPTY && packet->option != PACKET_DEFERRED) {
+        parser_write(packet, parser_sequence);
+    }
+}
+
+#if FRAME_BLOCK
+/**
+ * Check the length of a block message, the readers use the fields in the
+ * data also for the requests. The data of a chunk are exactly the bytes
+ * declared in the chunk, the other bytes of the message are not received.
+ * @param info message received
+ * @return true if the message has all fields used from the reader
+ */
+bool parser_block(packet_information_t* info) {
+    unsigned int length = info->length - LNG_HEAD_INFORMATION_PACKET;
+    if(info->option == PACKET_REQUEST) {
+        switch(info->command) {
+        case BLOCK_STATE:
+            return length >= 1;
+        case BLOCK_CHUNK:
+            return length >= LNG_HEAD_BLOCK_CHUNK;
+        case BLOCK_CHECK:
+            return length >= LNG_BLOCK_CHECK;
+        }
+    } else if(info->option == PACKET_DATA && info->command == BLOCK_CHUNK) {
+        return length >= LNG_HEAD_BLOCK_CHUNK
+                && length == LNG_HEAD_BLOCK_CHUNK + info->message.block.chunk.length;
+    }
+    return true;
+}
+#endif
+
+/**
+ * Compute a single message and append the reply in the output of the
+ * parser. The data (D) of messages in registry are validated before call the
+ * reader, a message with a wrong length is rejected with a NACK. The block
+ * messages are checked also on the fields (see parser_block).
+ */
+void parser_message(packet_information_t* info) {
     packet_information_t new_packet;
-    for (i = 0; i < receive_pkg->length; i += receive_pkg->buffer[i]) {
-        packet_information_t info;
-        memcpy((unsigned char*) &info, &receive_pkg->buffer[i], receive_pkg->buffer[i]);
-        // Alive frame
-        if(info.type == 0) {
-            new_packet = CREATE_PACKET_ACK(0, 0);
-            list_to_send[(*len)++] = new_packet;
+    int key, index;
+    // Alive frame
+    if(info->type == 0) {
+        new_packet = CREATE_PACKET_ACK(0, 0);
+        parser_append(&new_packet);
+        return;
+    }
+    key = get_key(info->type);
+    index = orb_registry_index(info->type, info->command);
+#if FRAME_SYSTEM
+    if(index == REGISTRY_SYSTEM_CAPABILITY || index == REGISTRY_SYSTEM_MODE) {
+        new_packet = parser_protocol(index, info);
+        parser_append(&new_packet);
+        return;
+    }
+#endif
+#if FRAME_BLOCK
+    if(info->type == HASHMAP_BLOCK && !parser_block(info)) {
+        new_packet = CREATE_PACKET_NACK(info->command, info->type);
+        parser_append(&new_packet);
+        return;
+    }
+#endif
+    switch (info->option) {
+    case PACKET_DATA:
+        if(index != REGISTRY_UNKNOWN && !orb_registry_check(index, info->length - LNG_HEAD_INFORMATION_PACKET)) {
+            new_packet = CREATE_PACKET_NACK(info->command, info->type);
         } else {
-            int key = get_key(info.type);
-            if(key != -1) {
-                switch (info.option) {
-                case PACKET_DATA:
-                    if(hash[key].reader.receive != NULL) {
-                        new_packet = hash[key].reader.receive(info.option, info.type, info.command, info.message);
-                        if(new_packet.option != PACKET_EMPTY){
-                            list_to_send[(*len)++] = new_packet;
-                        }
-                    }
-                    break;
-                case PACKET_REQUEST:
-                    if(hash[key].reader.send != NULL) {
-                        new_packet = hash[key].reader.send(info.option, info.type, info.command, info.message);
-                        if(new_packet.option != PACKET_EMPTY){
-                            list_to_send[(*len)++] = new_packet;
-                        }
-                    }
-                    break;
-                }
+            orb_cache_invalidate(info->type, info->command);
+            new_packet = parser_read(key, index, PACKET_DATA, info);
+        }
+        parser_append(&new_packet);
+        break;
+    case PACKET_REQUEST:
+        parser_append(parser_request(key, index, info, &new_packet));
+        break;
+    case PACKET_PATCH:
+        if(key != -1 || index != REGISTRY_UNKNOWN) {
+            orb_cache_invalidate(info->type, info->command);
+            new_packet = parser_patch(key, index, info);
+            parser_append(&new_packet);
+        }
+        break;
+    }
+}
+
+/**
+ * Parse the messages of the loaded packet in the output of the parser.
+ */
+bool parser_run(unsigned int messages, parser_clock_t clock, unsigned int budget) {
+    unsigned int start = 0, number = 0;
+    if(parser_receive == NULL) {
+        deferred_flush();
+        return true;
+    }
+    if(clock != NULL) {
+        start = clock();
+    }
+    while (parser_index < parser_receive->length) {
+        packet_information_t info;
+        unsigned char length = parser_receive->buffer[parser_index];
+        unsigned char size = length;
+        // Stop on a message without header or out of the packet
+        if(length < LNG_HEAD_INFORMATION_PACKET || parser_index + length > parser_receive->length) {
+            break;
+        }
+        // Wait a new output if there is not space for the reply
+        if(!parser_space()) {
+            return false;
+        }
+        // Remove the sequence number from the message
+        parser_sequence = SEQUENCE_NONE;
+        if(parser_receive->buffer[parser_index + 1] == PACKET_DATA_SEQ) {
+            size = length - LNG_PACKET_SEQUENCE;
+            parser_sequence = parser_receive->buffer[parser_index + size];
+        }
+        if(size < LNG_HEAD_INFORMATION_PACKET || size > sizeof(packet_information_t)) {
+            break;
+        }
+        memcpy((unsigned char*) &info, &parser_receive->buffer[parser_index], size);
+        if(parser_sequence != SEQUENCE_NONE) {
+            info.length = size;
+            info.option = PACKET_DATA;
+        }
+        parser_index += length;
+        parser_message(&info);
+        parser_sequence = SEQUENCE_NONE;
+        // Check the budget for this call
+        if(parser_index < parser_receive->length) {
+            if(messages != 0 && ++number >= messages) {
+                return false;
+            }
+            if(clock != NULL && (unsigned int) (clock() - start) >= budget) {
+                return false;
             }
         }
     }
+    parser_receive = NULL;
+    // Replies completed after the previous packet
+    deferred_flush();
     return true;
 }
 
+bool parser(packet_t* receive_pkg, packet_information_t* list_to_send, size_t* len) {
+    parser_load(receive_pkg);
+    return parser_resume(list_to_send, len, 0, NULL, 0);
+}
+
+bool parser_packet(packet_t* receive_pkg, packet_t* send_pkg) {
+    parser_load(receive_pkg);
+    send_pkg->length = 0;
+    return parser_resume_packet(send_pkg, 0, NULL, 0);
+}
+
+void parser_load(packet_t* receive_pkg) {
+    parser_receive = receive_pkg;
+    parser_index = 0;
+}
+
+bool parser_resume(packet_information_t* list_to_send, size_t* len, unsigned int messages, parser_clock_t clock, unsigned int budget) {
+    parser_output.list = list_to_send;
+    parser_output.len = len;
+    parser_output.size = BUFFER_LIST_PARSING;
+    parser_output.packet = NULL;
+    return parser_run(messages, clock, budget);
+}
+
+bool parser_resume_packet(packet_t* send_pkg, unsigned int messages, parser_clock_t clock, unsigned int budget) {
+    parser_output.list = NULL;
+    parser_output.len = NULL;
+    parser_output.size = 0;
+    parser_output.packet = send_pkg;
+    return parser_run(messages, clock, budget);
+}
+
+/******************************************************************************/
+/* Deferred replies                                                           */
+/******************************************************************************/
+
+int orb_deferred_open(unsigned char type, unsigned char command) {
+    int i;
+    for(i = 0; i < BUFFER_LIST_DEFERRED; ++i) {
+        if(deferred[i].state == DEFERRED_FREE) {
+            deferred[i].reply = CREATE_PACKET_NACK(command, type);
+            deferred[i].sequence = parser_sequence;
+            deferred[i].state = DEFERRED_PENDING;
+            return i;
+        }
+    }
+    return DEFERRED_INVALID;
+}
+
+bool orb_deferred_complete(int token, packet_information_t reply) {
+    if(token < 0 || token >= BUFFER_LIST_DEFERRED || deferred[token].state != DEFERRED_PENDING) {
+        return false;
+    }
+    if(reply.option == PACKET_EMPTY) {
+        deferred[token].state = DEFERRED_FREE;
+    } else {
+        parser_sequence_reply(&reply, deferred[token].sequence);
+        deferred[token].reply = reply;
+        deferred[token].state = DEFERRED_READY;
+    }
+    return true;
+}
+
+/**
+ * Append the completed deferred replies in the output of the parser, while
+ * there is space. The other replies are sent with the next flush.
+ */
+size_t deferred_flush() {
+    size_t i, number = 0;
+    for(i = 0; i < BUFFER_LIST_DEFERRED; ++i) {
+        if(deferred[i].state == DEFERRED_READY) {
+            if(!parser_write(&deferred[i].reply, SEQUENCE_NONE)) {
+                break;
+            }
+            deferred[i].state = DEFERRED_FREE;
+            number++;
+        }
+    }
+    return number;
+}
+
+size_t orb_deferred_flush(packet_information_t* list_to_send, size_t* len, size_t size) {
+    parser_output.list = list_to_send;
+    parser_output.len = len;
+    parser_output.size = size;
+    parser_output.packet = NULL;
+    return deferred_flush();
+}
+
+size_t orb_deferred_flush_packet(packet_t* send_pkg) {
+    parser_output.packet = send_pkg;
+    return deferred_flush();
+}
+
+/******************************************************************************/
+/* Cache of replies                                                           */
+/******************************************************************************/
+
+bool orb_cache_register(unsigned char type, unsigned char command) {
+    if(cache_find(type, command) != NULL) {
+        return true;
+    }
+    if(cache_counter >= BUFFER_LIST_CACHE) {
+        return false;
+    }
+    cache[cache_counter].type = type;
+    cache[cache_counter].command = command;
+    cache[cache_counter].valid = false;
+    cache[cache_counter].dirty = true;
+    cache_counter++;
+    return true;
+}
+
+void orb_cache_invalidate(unsigned char type, unsigned char command) {
+    cache_t* entry = cache_find(type, command);
+    if(entry != NULL) {
+        entry->dirty = true;
+    }
+}
+
+/******************************************************************************/
+/* Encoding functions                                                         */
+/******************************************************************************/
+
 unsigned int encoder(packet_t *packet_send, packet_information_t *list_send, size_t len) {
     int i;
     packet_send->length = 0;
@@ -154,3 +665,15 @@ packet_information_t createPacket(unsigned char command, unsigned char option, u
 inline packet_information_t createDataPacket(unsigned char command, unsigned char type, message_abstract_u * packet, size_t len) {
     return createPacket(command, PACKET_DATA, type, packet, len);
 }
+
+packet_information_t createPatchPacket(unsigned char command, unsigned char type, size_t offset, const void * data, size_t len) {
+    message_abstract_u message;
+    // The offset is one byte on the bus, the bytes must be in a message
+    if(len == 0 || len > MAX_BUFF_PATCH || offset + len > sizeof(message_abstract_u)) {
+        return CREATE_PACKET_EMPTY;
+    }
+    message.patch.offset = offset;
+    message.patch.length = len;
+    memcpy(message.patch.data, data, len);
+    return createPacket(command, PACKET_PATCH, type, &message, LNG_MESSAGE_PATCH(len));
+}
@@ -29,73 +29,209 @@
 /* Global Variable Declaration                                                */
 /******************************************************************************/
 
-/*! Pointer to function, initialized for pkg_header */
-int (*pkg_parse) (unsigned char inchar) = &pkg_header;
-
-/*! Receive packet */
-packet_t* packet_receive;
-unsigned int index_data = 0;
+/*! Decoder of the serial port, used from decode_pkgs */
+decoder_t decoder_serial = {&decoder_header, NULL, 0, NULL, 0, SYSTEM_INTEGRITY_SUM, 0};
 system_error_serial_t serial_error;
+/*! Integrity mode of the serial port after the next frame */
+unsigned char serial_integrity = SYSTEM_INTEGRITY_SUM;
+bool serial_pending = false;
+/*! Integrity modes allowed on the serial port */
+unsigned char serial_modes = SYSTEM_INTEGRITY_SUM;
+
+/*! CRC16 CCITT (0x1021) for each nibble */
+const uint16_t crc16_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/******************************************************************************/
+/* Integrity Functions                                                        */
+/******************************************************************************/
+
+/**
+ * Add a byte in the check.
+ */
+uint16_t integrity_byte(unsigned char integrity, uint16_t checksum, unsigned char byte) {
+    if (integrity == SYSTEM_INTEGRITY_CRC16) {
+        checksum = (checksum << 4) ^ crc16_table[(checksum >> 12) ^ (byte >> 4)];
+        return (checksum << 4) ^ crc16_table[(checksum >> 12) ^ (byte & 0x0F)];
+    }
+    return checksum + byte;
+}
+
+/**
+ * Number of bytes of the check in tail of a frame.
+ */
+unsigned int integrity_size(unsigned char integrity) {
+    switch (integrity) {
+        case SYSTEM_INTEGRITY_CRC16:
+            return 2;
+        case SYSTEM_INTEGRITY_NONE:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+uint16_t orb_integrity_init(unsigned char integrity) {
+    return integrity == SYSTEM_INTEGRITY_CRC16 ? 0xFFFF : 0;
+}
+
+uint16_t orb_integrity_update(unsigned char integrity, uint16_t checksum, const unsigned char* buffer, size_t length) {
+    size_t i;
+    for (i = 0; i < length; i++) {
+        checksum = integrity_byte(integrity, checksum, buffer[i]);
+    }
+    return checksum;
+}
+
+unsigned int orb_integrity_tail(unsigned char integrity, uint16_t checksum, unsigned char* tail) {
+    unsigned int size = integrity_size(integrity), i;
+    for (i = 0; i < size; i++) {
+        tail[i] = checksum >> (8 * (size - 1 - i));
+    }
+    return size;
+}
 
 /******************************************************************************/
 /* Communication Functions                                                    */
 /******************************************************************************/
 
 void orb_message_init(packet_t* packet_rx) {
-    packet_receive = packet_rx;
-    memset(serial_error, 0, MAX_BUFF_ERROR_SERIAL);
+    memset(serial_error, 0, sizeof(system_error_serial_t));
+    orb_decoder_init(&decoder_serial, packet_rx, serial_error);
+    serial_integrity = SYSTEM_INTEGRITY_SUM;
+    serial_pending = false;
+    serial_modes = SYSTEM_INTEGRITY_SUM;
 }
 
-int decode_pkgs(unsigned char rxchar) {
-    return (*pkg_parse)(rxchar);
+void orb_decoder_init(decoder_t* decoder, packet_t* packet_rx, int16_t* error) {
+    decoder->parse = &decoder_header;
+    decoder->packet = packet_rx;
+    decoder->index = 0;
+    decoder->error = error;
+    decoder->checksum = 0;
+    decoder->integrity = SYSTEM_INTEGRITY_SUM;
+    decoder->errors = 0;
 }
 
-int pkg_header(unsigned char rxchar) {
+unsigned char orb_message_integrity() {
+    return decoder_serial.integrity;
+}
+
+void orb_message_negotiate(unsigned char integrity) {
+    serial_modes = (integrity & MESSAGE_INTEGRITY) | SYSTEM_INTEGRITY_SUM;
+}
+
+unsigned char orb_message_modes() {
+    return serial_modes;
+}
+
+bool orb_message_mode(unsigned char integrity) {
+    if ((integrity & serial_modes) == 0 || (integrity & (integrity - 1)) != 0) {
+        return false;
+    }
+    serial_integrity = integrity;
+    serial_pending = true;
+    return true;
+}
+
+int orb_decoder_pkgs(decoder_t* decoder, unsigned char rxchar) {
+    return (*decoder->parse)(decoder, rxchar);
+}
+
+int decoder_header(decoder_t* decoder, unsigned char rxchar) {
     if (rxchar == PACKET_HEADER) {
-        pkg_parse = &pkg_length;
+        decoder->parse = &decoder_length;
         return false;
     } else {
-        pkg_error(ERROR_HEADER);
+        decoder_error(decoder, ERROR_HEADER);
         return false;
     }
 }
 
-int pkg_length(unsigned char rxchar) {
+int decoder_length(decoder_t* decoder, unsigned char rxchar) {
     if (rxchar > MAX_BUFF_RX) {
-        pkg_error(ERROR_LENGTH);
+        decoder_error(decoder, ERROR_LENGTH);
         return false;
     } else {
-        pkg_parse = &pkg_data;
-        packet_receive->length = rxchar;
+        decoder->parse = &decoder_data;
+        decoder->packet->length = rxchar;
+        decoder->checksum = orb_integrity_init(decoder->integrity);
+        if (rxchar == 0 && decoder->integrity == SYSTEM_INTEGRITY_NONE) {
+            decoder->parse = &decoder_header;
+            decoder->errors = 0;
+            return true;
+        }
         return false;
     }
 }
 
-int pkg_data(unsigned char rxchar) {
-    int cks_clc;
-    if ((index_data + 1) == (packet_receive->length + 1)) {
-        pkg_parse = &pkg_header; //Restart parse serial packet
-        if ((cks_clc = pkg_checksum(packet_receive->buffer, 0, index_data)) == rxchar) { //checksum data
-            index_data = 0; //flush index array data buffer
+int decoder_data(decoder_t* decoder, unsigned char rxchar) {
+    unsigned int length = decoder->packet->length;
+    if (decoder->index < length) {
+        decoder->packet->buffer[decoder->index] = rxchar;
+        // Checksum computed for each byte
+        decoder->checksum = integrity_byte(decoder->integrity, decoder->checksum, rxchar);
+        decoder->index++;
+        if (decoder->index == length && decoder->integrity == SYSTEM_INTEGRITY_NONE) {
+            decoder->parse = &decoder_header; //Restart parse serial packet
+            decoder->index = 0;
+            decoder->errors = 0;
             return true;
-        } else {
-            pkg_error(ERROR_CKS);
-            return false;
         }
-    } else {
-        packet_receive->buffer[index_data] = rxchar;
-        index_data++;
         return false;
     }
+    // Check in tail, the most significant byte first
+    length += integrity_size(decoder->integrity);
+    if ((unsigned char) (decoder->checksum >> (8 * (length - 1 - decoder->index))) != rxchar) {
+        decoder_error(decoder, ERROR_CKS);
+        return false;
+    }
+    if (++decoder->index == length) {
+        decoder->parse = &decoder_header; //Restart parse serial packet
+        decoder->index = 0; //flush index array data buffer
+        decoder->errors = 0;
+        return true;
+    }
+    return false;
 }
 
-int pkg_error(int error) {
-    index_data = 0;
-    pkg_parse = &pkg_header; //Restart parse serial packet
-    serial_error[(-error - 1)] += 1;
+int decoder_error(decoder_t* decoder, int error) {
+    decoder->index = 0;
+    decoder->parse = &decoder_header; //Restart parse serial packet
+    if (decoder->error != NULL) {
+        decoder->error[(-error - 1)] += 1;
+    }
+    // The peer sends frames in another mode, go back to the default mode
+    if (error == ERROR_CKS && decoder->integrity != SYSTEM_INTEGRITY_SUM
+            && ++decoder->errors >= DECODER_FALLBACK) {
+        decoder->integrity = SYSTEM_INTEGRITY_SUM;
+        decoder->errors = 0;
+    }
     return error;
 }
 
+int decode_pkgs(unsigned char rxchar) {
+    return orb_decoder_pkgs(&decoder_serial, rxchar);
+}
+
+int pkg_header(unsigned char rxchar) {
+    return decoder_header(&decoder_serial, rxchar);
+}
+
+int pkg_length(unsigned char rxchar) {
+    return decoder_length(&decoder_serial, rxchar);
+}
+
+int pkg_data(unsigned char rxchar) {
+    return decoder_data(&decoder_serial, rxchar);
+}
+
+int pkg_error(int error) {
+    return decoder_error(&decoder_serial, error);
+}
+
 unsigned char pkg_checksum(volatile unsigned char* Buffer, int FirstIndx, int LastIndx) {
     unsigned char ChkSum = 0;
     int ChkCnt;
@@ -105,17 +241,28 @@ unsigned char pkg_checksum(volatile unsigned char* Buffer, int FirstIndx, int La
     return ChkSum;
 }
 
-void build_pkg(unsigned char * BufferTx, packet_t packet) {
-
-    int i;
+unsigned int orb_build_frame(unsigned char* BufferTx, const packet_t* packet, unsigned char integrity) {
+    uint16_t checksum;
     BufferTx[0] = PACKET_HEADER;
-    BufferTx[1] = packet.length;
-
+    BufferTx[1] = packet->length;
     //Copy all element to DMA buffer
-    for (i = 0; i < packet.length; i++) {
-        BufferTx[i + LNG_PACKET_HEADER] = packet.buffer[i];
+    memcpy(&BufferTx[LNG_PACKET_HEADER], packet->buffer, packet->length);
+    // Create a checksum
+    checksum = orb_integrity_update(integrity, orb_integrity_init(integrity), packet->buffer, packet->length);
+    return packet->length + LNG_PACKET_HEADER
+            + orb_integrity_tail(integrity, checksum, &BufferTx[packet->length + LNG_PACKET_HEADER]);
+}
+
+unsigned int orb_build_pkg(unsigned char* BufferTx, const packet_t* packet) {
+    unsigned int length = orb_build_frame(BufferTx, packet, decoder_serial.integrity);
+    // New mode after the frame with the ACK
+    if (serial_pending) {
+        decoder_serial.integrity = serial_integrity;
+        serial_pending = false;
     }
+    return length;
+}
 
-    // Create a checksum
-    BufferTx[packet.length + LNG_PACKET_HEADER] = pkg_checksum(BufferTx, LNG_PACKET_HEADER, packet.length + LNG_PACKET_HEADER);
-}
\ No newline at end of file
+void build_pkg(unsigned char * BufferTx, packet_t packet) {
+    orb_build_frame(BufferTx, &packet, SYSTEM_INTEGRITY_SUM);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_bus/or_registry.h"
+
+/******************************************************************************/
+/* Tables generated from registry                                             */
+/******************************************************************************/
+
+#define REGISTRY_LENGTH(command, payload, check) { sizeof(payload), check },
+#define REGISTRY_FAMILY_LENGTH(type, messages, map) messages(REGISTRY_LENGTH)
+const registry_length_t registry_length[REGISTRY_NUMBER] = {
+    FRAME_REGISTRY(REGISTRY_FAMILY_LENGTH)
+};
+
+/******************************************************************************/
+/* Registry functions                                                         */
+/******************************************************************************/
+
+int orb_registry_index(unsigned char type, unsigned char command) {
+    #define REGISTRY_CASE(command, payload, check) case command: return REGISTRY_##command;
+    #define REGISTRY_FAMILY_CASE(type, messages, map)   \
+        case type:                                      \
+            switch(map(command)) {                      \
+                messages(REGISTRY_CASE)                 \
+            }                                           \
+            break;
+    switch(type) {
+        FRAME_REGISTRY(REGISTRY_FAMILY_CASE)
+    }
+    return REGISTRY_UNKNOWN;
+}
+
+size_t orb_registry_size(int index) {
+    return registry_length[index].size;
+}
+
+bool orb_registry_check(int index, size_t length) {
+    if(registry_length[index].check == FRAME_CHECK_MAX) {
+        return length <= registry_length[index].size;
+    }
+    return length == registry_length[index].size;
+}
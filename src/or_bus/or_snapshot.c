@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_bus/or_frame.h"
+#include "or_bus/or_snapshot.h"
+
+/*! On a single core MCU is enough to stop the reordering of the compiler */
+#if defined(__XC16__)
+#define SNAPSHOT_BARRIER() __asm__ volatile ("" ::: "memory")
+#else
+#define SNAPSHOT_BARRIER() __sync_synchronize()
+#endif
+
+/******************************************************************************/
+/* Snapshot functions                                                         */
+/******************************************************************************/
+
+void orb_snapshot_init(snapshot_t* snapshot, volatile void* data, size_t size) {
+    snapshot->sequence = 0;
+    snapshot->data = data;
+    snapshot->size = size;
+}
+
+void orb_snapshot_write_begin(snapshot_t* snapshot) {
+    snapshot->sequence++;
+    SNAPSHOT_BARRIER();
+}
+
+void orb_snapshot_write_end(snapshot_t* snapshot) {
+    SNAPSHOT_BARRIER();
+    snapshot->sequence++;
+}
+
+void orb_snapshot_write(snapshot_t* snapshot, const void* value) {
+    orb_snapshot_write_begin(snapshot);
+    memcpy((void*) snapshot->data, value, snapshot->size);
+    orb_snapshot_write_end(snapshot);
+}
+
+bool orb_snapshot_read(snapshot_t* snapshot, void* copy) {
+    uint16_t sequence;
+    unsigned short retry = 0;
+    do {
+        sequence = snapshot->sequence;
+        SNAPSHOT_BARRIER();
+        // The writer is updating the message
+        if(sequence & 1) {
+            continue;
+        }
+        memcpy(copy, (void*) snapshot->data, snapshot->size);
+        SNAPSHOT_BARRIER();
+        if(snapshot->sequence == sequence) {
+            return true;
+        }
+    } while(++retry < SNAPSHOT_RETRY);
+    return false;
+}
+
+packet_information_t orb_snapshot_packet(snapshot_t* snapshot, unsigned char command, unsigned char type) {
+    packet_information_t information;
+    if(snapshot->size > sizeof(message_abstract_u) || !orb_snapshot_read(snapshot, &information.message)) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    information.command = command;
+    information.option = PACKET_DATA;
+    information.type = type;
+    information.length = LNG_HEAD_INFORMATION_PACKET + snapshot->size;
+    return information;
+}
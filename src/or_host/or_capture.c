@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "or_host/or_capture.h"
+
+/******************************************************************************/
+/* Capture functions                                                          */
+/******************************************************************************/
+
+int orb_capture_open(capture_t* capture, const char* path) {
+    struct stat info;
+    capture->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(capture->fd < 0) {
+        return -1;
+    }
+    if(fstat(capture->fd, &info) < 0) {
+        close(capture->fd);
+        return -1;
+    }
+    if(info.st_size == 0) {
+        capture_file_t header;
+        memset(&header, 0, sizeof(header));
+        header.magic = CAPTURE_MAGIC;
+        header.version = CAPTURE_VERSION;
+        header.size = sizeof(capture_file_t);
+        if(write(capture->fd, &header, sizeof(header)) != sizeof(header)) {
+            close(capture->fd);
+            return -1;
+        }
+    }
+    pthread_mutex_init(&capture->lock, NULL);
+    return 0;
+}
+
+void orb_capture_close(capture_t* capture) {
+    close(capture->fd);
+    pthread_mutex_destroy(&capture->lock);
+}
+
+uint64_t orb_capture_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int orb_capture_write(capture_t* capture, uint16_t kind, uint16_t link, const void* data, uint32_t length, uint64_t time) {
+    static const unsigned char padding[CAPTURE_ALIGN] = {0};
+    capture_record_t record;
+    struct iovec vector[3];
+    ssize_t size = sizeof(record) + CAPTURE_PAD(length), written;
+    record.kind = kind;
+    record.link = link;
+    record.length = length;
+    record.time = time;
+    vector[0].iov_base = &record;
+    vector[0].iov_len = sizeof(record);
+    vector[1].iov_base = (void*) data;
+    vector[1].iov_len = length;
+    vector[2].iov_base = (void*) padding;
+    vector[2].iov_len = CAPTURE_PAD(length) - length;
+    // A record is written with a single write, the records are not mixed
+    pthread_mutex_lock(&capture->lock);
+    written = writev(capture->fd, vector, 3);
+    pthread_mutex_unlock(&capture->lock);
+    return written == size ? 0 : -1;
+}
+
+int orb_capture_packet(capture_t* capture, uint16_t link, packet_t* packet, uint64_t time) {
+    return orb_capture_write(capture, CAPTURE_PACKET, link, packet->buffer, packet->length, time);
+}
+
+int orb_capture_mode(capture_t* capture, uint16_t link, unsigned char integrity, uint64_t time) {
+    return orb_capture_write(capture, CAPTURE_MODE, link, &integrity, sizeof(integrity), time);
+}
+
+int orb_capture_map(capture_map_t* map, const char* path) {
+    struct stat info;
+    const capture_file_t* header;
+    void* data;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return -1;
+    }
+    if(fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(capture_file_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        return -1;
+    }
+    header = (const capture_file_t*) data;
+    if(header->magic != CAPTURE_MAGIC || header->version != CAPTURE_VERSION
+            || header->size < sizeof(capture_file_t)) {
+        munmap(data, info.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+    map->data = (const unsigned char*) data;
+    map->size = info.st_size;
+    return 0;
+}
+
+void orb_capture_unmap(capture_map_t* map) {
+    munmap((void*) map->data, map->size);
+    map->data = NULL;
+    map->size = 0;
+}
+
+const capture_record_t* orb_capture_next(const capture_map_t* map, size_t* offset) {
+    const capture_record_t* record;
+    if(*offset == 0) {
+        *offset = ((const capture_file_t*) map->data)->size;
+    }
+    if(*offset + sizeof(capture_record_t) > map->size) {
+        return NULL;
+    }
+    record = (const capture_record_t*) (map->data + *offset);
+    // Truncated record at the end of the file
+    if(record->length > map->size - *offset - sizeof(capture_record_t)) {
+        return NULL;
+    }
+    *offset += sizeof(capture_record_t) + CAPTURE_PAD(record->length);
+    return record;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_bus/or_frame.h"
+#include "or_host/or_client.h"
+
+#define CLIENT_FREE 0
+#define CLIENT_QUEUED 1
+#define CLIENT_SENT 2
+
+/******************************************************************************/
+/* Client functions                                                           */
+/******************************************************************************/
+
+void orb_client_init(client_t* client, unsigned int timeout, client_callback_t callback, void* data) {
+    unsigned int i;
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        client->entry[i].state = CLIENT_FREE;
+    }
+    client->order = 0;
+    client->timeout = timeout;
+    client->callback = callback;
+    client->data = data;
+}
+
+bool orb_client_send(client_t* client, packet_information_t* message, client_callback_t callback, void* data) {
+    unsigned int i;
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        client_entry_t* entry = &client->entry[i];
+        if(entry->state == CLIENT_FREE) {
+            memcpy(&entry->message, message, message->length);
+            entry->order = client->order++;
+            entry->callback = callback;
+            entry->data = data;
+            entry->state = CLIENT_QUEUED;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool orb_client_request(client_t* client, unsigned char type, unsigned char command, client_callback_t callback, void* data) {
+    packet_information_t message = CREATE_PACKET_RESPONSE(command, type, PACKET_REQUEST);
+    return orb_client_send(client, &message, callback, data);
+}
+
+/**
+ * Release a request and call its callback with the result.
+ */
+void client_complete(client_entry_t* entry, packet_information_t* message, unsigned char result) {
+    entry->state = CLIENT_FREE;
+    if(entry->callback != NULL) {
+        entry->callback(entry->data, message, result);
+    }
+}
+
+unsigned int orb_client_expire(client_t* client, unsigned int now) {
+    unsigned int i, number = 0;
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        client_entry_t* entry = &client->entry[i];
+        if(entry->state == CLIENT_SENT && (unsigned int) (now - entry->time) >= client->timeout) {
+            client_complete(entry, &entry->message, CLIENT_TIMEOUT);
+            number++;
+        }
+    }
+    return number;
+}
+
+/**
+ * Requests queued, from the oldest to the newest.
+ * @return number of requests
+ */
+unsigned int client_queued(client_t* client, client_entry_t** order) {
+    unsigned int i, j, number = 0;
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        client_entry_t* entry = &client->entry[i];
+        if(entry->state != CLIENT_QUEUED) {
+            continue;
+        }
+        for(j = number; j > 0 && (int) (entry->order - order[j - 1]->order) < 0; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = entry;
+        number++;
+    }
+    return number;
+}
+
+unsigned int orb_client_encode(client_t* client, packet_t* packet, unsigned int now) {
+    client_entry_t* order[CLIENT_SIZE];
+    unsigned int i, number = 0, entries;
+    orb_client_expire(client, now);
+    entries = client_queued(client, order);
+    for(i = 0; i < entries; ++i) {
+        client_entry_t* entry = order[i];
+        unsigned char length = entry->message.length;
+        // Check if the size can enter in the buffer, the next requests
+        // wait the next packet to keep the order
+        if(packet->length + length > MAX_BUFF_TX) {
+            break;
+        }
+        memcpy(&packet->buffer[packet->length], &entry->message, length);
+        packet->length += length;
+        entry->time = now;
+        entry->state = CLIENT_SENT;
+        number++;
+    }
+    return number;
+}
+
+bool orb_client_reply(client_t* client, packet_information_t* reply) {
+    unsigned int i;
+    client_entry_t* oldest = NULL;
+    // Reply of a write with sequence number
+    if(reply->length == LNG_HEAD_INFORMATION_PACKET + LNG_PACKET_SEQUENCE
+            && (reply->option == PACKET_ACK || reply->option == PACKET_NACK)) {
+        return false;
+    }
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        client_entry_t* entry = &client->entry[i];
+        if(entry->state == CLIENT_SENT && entry->message.type == reply->type
+                && entry->message.command == reply->command) {
+            if(oldest == NULL || (int) (entry->order - oldest->order) < 0) {
+                oldest = entry;
+            }
+        }
+    }
+    if(oldest == NULL) {
+        return false;
+    }
+    client_complete(oldest, reply, reply->option == PACKET_NACK ? CLIENT_NACK : CLIENT_REPLY);
+    return true;
+}
+
+unsigned int orb_client_receive(client_t* client, packet_t* packet) {
+    unsigned int index = 0, number = 0;
+    while (index < packet->length) {
+        packet_information_t message;
+        unsigned char length = packet->buffer[index];
+        // Stop on a message without header or out of the packet
+        if(length < LNG_HEAD_INFORMATION_PACKET || length > sizeof(packet_information_t)
+                || index + length > packet->length) {
+            break;
+        }
+        memcpy(&message, &packet->buffer[index], length);
+        index += length;
+        if(orb_client_reply(client, &message)) {
+            number++;
+        } else if(client->callback != NULL) {
+            client->callback(client->data, &message, CLIENT_UNSOLICITED);
+        }
+    }
+    return number;
+}
+
+unsigned int orb_client_pending(client_t* client) {
+    unsigned int i, number = 0;
+    for(i = 0; i < CLIENT_SIZE; ++i) {
+        if(client->entry[i].state != CLIENT_FREE) {
+            number++;
+        }
+    }
+    return number;
+}
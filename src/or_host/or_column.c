@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "or_host/or_column.h"
+
+// Independent accumulators for the vectorization
+#define COLUMN_LANES 8
+
+/******************************************************************************/
+/* Fields of messages                                                         */
+/******************************************************************************/
+
+#ifdef HASHMAP_MOTOR
+const column_field_t column_motor[COLUMN_MOTOR_FIELDS] = {
+    {"pwm", offsetof(motor_t, pwm), COLUMN_INT32},
+    {"effort", offsetof(motor_t, effort), COLUMN_INT32},
+    {"current", offsetof(motor_t, current), COLUMN_INT32},
+    {"velocity", offsetof(motor_t, velocity), COLUMN_INT32},
+    {"position", offsetof(motor_t, position), COLUMN_FLOAT},
+    {"position_delta", offsetof(motor_t, position_delta), COLUMN_FLOAT},
+};
+
+const column_field_t column_diagnostic[COLUMN_DIAGNOSTIC_FIELDS] = {
+    {"state", offsetof(motor_diagnostic_t, state), COLUMN_INT8},
+    {"watt", offsetof(motor_diagnostic_t, watt), COLUMN_INT32},
+    {"volt", offsetof(motor_diagnostic_t, volt), COLUMN_UINT16},
+    {"temperature", offsetof(motor_diagnostic_t, temperature), COLUMN_UINT16},
+    {"time_control", offsetof(motor_diagnostic_t, time_control), COLUMN_UINT32},
+};
+#endif
+
+/******************************************************************************/
+/* Table functions                                                            */
+/******************************************************************************/
+
+bool orb_column_init(column_table_t* table, const column_field_t* field, unsigned int fields, size_t capacity) {
+    if(capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    table->data = (float*) malloc(fields * capacity * sizeof(float));
+    if(table->data == NULL) {
+        return false;
+    }
+    table->field = field;
+    table->fields = fields;
+    table->capacity = capacity;
+    table->count = 0;
+    return true;
+}
+
+void orb_column_free(column_table_t* table) {
+    free(table->data);
+    table->data = NULL;
+}
+
+void orb_column_append(column_table_t* table, const void* message) {
+    size_t position = table->count & (table->capacity - 1);
+    unsigned int i;
+    for(i = 0; i < table->fields; ++i) {
+        const unsigned char* data = (const unsigned char*) message + table->field[i].offset;
+        float value;
+        switch(table->field[i].type) {
+        case COLUMN_INT8:
+            value = (int8_t) data[0];
+            break;
+        case COLUMN_UINT16:
+            value = wire_get_uint16(data);
+            break;
+        case COLUMN_INT32:
+            value = (int32_t) wire_get_uint32(data);
+            break;
+        case COLUMN_UINT32:
+            value = wire_get_uint32(data);
+            break;
+        default:
+            value = wire_get_float(data);
+            break;
+        }
+        table->data[i * table->capacity + position] = value;
+    }
+    table->count++;
+}
+
+size_t orb_column_size(const column_table_t* table) {
+    return table->count < table->capacity ? table->count : table->capacity;
+}
+
+/**
+ * The last samples of a column are in one or two segments of the array.
+ * @return number of samples
+ */
+size_t column_segments(const column_table_t* table, unsigned int field, size_t last,
+        const float** first, size_t* first_length, const float** second, size_t* second_length) {
+    const float* column = &table->data[field * table->capacity];
+    size_t size = orb_column_size(table);
+    size_t end = table->count & (table->capacity - 1);
+    size_t start;
+    if(last == 0 || last > size) {
+        last = size;
+    }
+    start = (table->count - last) & (table->capacity - 1);
+    if(last == 0) {
+        *first_length = *second_length = 0;
+    } else if(start < end) {
+        *first = column + start;
+        *first_length = end - start;
+        *second_length = 0;
+    } else {
+        *first = column + start;
+        *first_length = table->capacity - start;
+        *second = column;
+        *second_length = end;
+    }
+    return last;
+}
+
+float orb_column_min(const float* data, size_t length) {
+    float lane[COLUMN_LANES];
+    size_t i, j;
+    for(j = 0; j < COLUMN_LANES; ++j) {
+        lane[j] = FLT_MAX;
+    }
+    for(i = 0; i + COLUMN_LANES <= length; i += COLUMN_LANES) {
+        for(j = 0; j < COLUMN_LANES; ++j) {
+            lane[j] = data[i + j] < lane[j] ? data[i + j] : lane[j];
+        }
+    }
+    for(; i < length; ++i) {
+        lane[0] = data[i] < lane[0] ? data[i] : lane[0];
+    }
+    for(j = 1; j < COLUMN_LANES; ++j) {
+        lane[0] = lane[j] < lane[0] ? lane[j] : lane[0];
+    }
+    return lane[0];
+}
+
+float orb_column_max(const float* data, size_t length) {
+    float lane[COLUMN_LANES];
+    size_t i, j;
+    for(j = 0; j < COLUMN_LANES; ++j) {
+        lane[j] = -FLT_MAX;
+    }
+    for(i = 0; i + COLUMN_LANES <= length; i += COLUMN_LANES) {
+        for(j = 0; j < COLUMN_LANES; ++j) {
+            lane[j] = data[i + j] > lane[j] ? data[i + j] : lane[j];
+        }
+    }
+    for(; i < length; ++i) {
+        lane[0] = data[i] > lane[0] ? data[i] : lane[0];
+    }
+    for(j = 1; j < COLUMN_LANES; ++j) {
+        lane[0] = lane[j] > lane[0] ? lane[j] : lane[0];
+    }
+    return lane[0];
+}
+
+double orb_column_sum(const float* data, size_t length) {
+    double lane[COLUMN_LANES] = {0};
+    double sum = 0;
+    size_t i, j;
+    for(i = 0; i + COLUMN_LANES <= length; i += COLUMN_LANES) {
+        for(j = 0; j < COLUMN_LANES; ++j) {
+            lane[j] += data[i + j];
+        }
+    }
+    for(; i < length; ++i) {
+        sum += data[i];
+    }
+    for(j = 0; j < COLUMN_LANES; ++j) {
+        sum += lane[j];
+    }
+    return sum;
+}
+
+void orb_column_stats(const column_table_t* table, unsigned int field, size_t last, column_stats_t* stats) {
+    const float *first = NULL, *second = NULL;
+    size_t first_length, second_length;
+    stats->count = column_segments(table, field, last, &first, &first_length, &second, &second_length);
+    if(stats->count == 0) {
+        stats->min = stats->max = stats->mean = 0;
+        return;
+    }
+    stats->min = orb_column_min(first, first_length);
+    stats->max = orb_column_max(first, first_length);
+    stats->mean = orb_column_sum(first, first_length);
+    if(second_length > 0) {
+        float min = orb_column_min(second, second_length);
+        float max = orb_column_max(second, second_length);
+        stats->min = min < stats->min ? min : stats->min;
+        stats->max = max > stats->max ? max : stats->max;
+        stats->mean += orb_column_sum(second, second_length);
+    }
+    stats->mean /= stats->count;
+}
+
+/**
+ * k-th smallest value of an array, the array is reordered.
+ */
+float column_select(float* data, size_t length, size_t k) {
+    size_t left = 0, right = length - 1;
+    while(left < right) {
+        float pivot = data[left + (right - left) / 2];
+        size_t i = left, j = right;
+        while(i <= j) {
+            while(data[i] < pivot) {
+                i++;
+            }
+            while(data[j] > pivot) {
+                j--;
+            }
+            if(i <= j) {
+                float swap = data[i];
+                data[i] = data[j];
+                data[j] = swap;
+                i++;
+                if(j == 0) {
+                    break;
+                }
+                j--;
+            }
+        }
+        if(k <= j) {
+            right = j;
+        } else if(k >= i) {
+            left = i;
+        } else {
+            break;
+        }
+    }
+    return data[k];
+}
+
+bool orb_column_percentile(const column_table_t* table, unsigned int field, size_t last,
+        const float* percentile, float* value, unsigned int number) {
+    const float *first = NULL, *second = NULL;
+    size_t first_length, second_length, count;
+    unsigned int i;
+    float* copy;
+    count = column_segments(table, field, last, &first, &first_length, &second, &second_length);
+    if(count == 0) {
+        return false;
+    }
+    copy = (float*) malloc(count * sizeof(float));
+    if(copy == NULL) {
+        return false;
+    }
+    memcpy(copy, first, first_length * sizeof(float));
+    if(second_length > 0) {
+        memcpy(copy + first_length, second, second_length * sizeof(float));
+    }
+    for(i = 0; i < number; ++i) {
+        float p = percentile[i] < 0 ? 0 : (percentile[i] > 100 ? 100 : percentile[i]);
+        // Nearest rank
+        size_t k = (size_t) (p / 100.0f * (count - 1) + 0.5f);
+        value[i] = column_select(copy, count, k);
+    }
+    free(copy);
+    return true;
+}
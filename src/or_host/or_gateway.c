@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "or_host/or_gateway.h"
+
+/******************************************************************************/
+/* Gateway functions                                                          */
+/******************************************************************************/
+
+int orb_gateway_init(gateway_t* gateway, gateway_callback_t callback, void* data) {
+    gateway->links = 0;
+    gateway->workers = 0;
+    gateway->running = false;
+    gateway->callback = callback;
+    gateway->data = data;
+    gateway->capture = NULL;
+    gateway->epoll = epoll_create1(EPOLL_CLOEXEC);
+    return gateway->epoll < 0 ? -1 : 0;
+}
+
+/**
+ * Wait the next data on a link, from only one worker.
+ */
+int gateway_arm(gateway_t* gateway, int link, int operation) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u32 = link;
+    return epoll_ctl(gateway->epoll, operation, gateway->link[link].fd, &event);
+}
+
+int orb_gateway_add(gateway_t* gateway, int fd) {
+    int link = gateway->links, flags;
+    gateway_link_t* entry;
+    if(link >= GATEWAY_LINKS) {
+        errno = ENOSPC;
+        return -1;
+    }
+    entry = &gateway->link[link];
+    flags = fcntl(fd, F_GETFL);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return -1;
+    }
+    entry->fd = fd;
+    memset(entry->error, 0, sizeof(system_error_serial_t));
+    orb_decoder_init(&entry->decoder, &entry->packet, entry->error);
+    entry->integrity = entry->decoder.integrity;
+    entry->pending = 0;
+    pthread_mutex_init(&entry->write, NULL);
+    if(gateway_arm(gateway, link, EPOLL_CTL_ADD) < 0) {
+        pthread_mutex_destroy(&entry->write);
+        return -1;
+    }
+    gateway->links++;
+    return link;
+}
+
+int orb_gateway_open(gateway_t* gateway, const char* path, speed_t baud) {
+    struct termios tty;
+    int link;
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if(fd < 0) {
+        return -1;
+    }
+    if(tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, baud);
+        cfsetospeed(&tty, baud);
+        tty.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    link = orb_gateway_add(gateway, fd);
+    if(link < 0) {
+        close(fd);
+    }
+    return link;
+}
+
+/**
+ * Align the modes of a link: a new mode for the decoder is applied (and
+ * recorded in the capture) before the next bytes, otherwise the frames are
+ * sent in the mode of the decoder, that returns in SUM after too many
+ * checksum errors.
+ */
+void gateway_sync(gateway_t* gateway, int link) {
+    gateway_link_t* entry = &gateway->link[link];
+    pthread_mutex_lock(&entry->write);
+    if(entry->pending != 0) {
+        entry->decoder.integrity = entry->pending;
+        entry->pending = 0;
+        if(gateway->capture != NULL) {
+            orb_capture_mode(gateway->capture, link, entry->decoder.integrity, orb_capture_time());
+        }
+    } else {
+        entry->integrity = entry->decoder.integrity;
+    }
+    pthread_mutex_unlock(&entry->write);
+}
+
+/**
+ * Read all data of a link and call the callback for each packet decoded.
+ * @return false if the link is closed
+ */
+bool gateway_read(gateway_t* gateway, int link) {
+    gateway_link_t* entry = &gateway->link[link];
+    unsigned char buffer[GATEWAY_READ];
+    ssize_t i, length;
+    uint64_t time = 0;
+    for(;;) {
+        gateway_sync(gateway, link);
+        length = read(entry->fd, buffer, GATEWAY_READ);
+        if(length < 0 && errno == EINTR) {
+            continue;
+        }
+        if(length <= 0) {
+            break;
+        }
+        if(gateway->capture != NULL) {
+            time = orb_capture_time();
+            orb_capture_write(gateway->capture, CAPTURE_RAW_RX, link, buffer, length, time);
+        }
+        for(i = 0; i < length; ++i) {
+            if(orb_decoder_pkgs(&entry->decoder, buffer[i])) {
+                if(gateway->capture != NULL) {
+                    orb_capture_packet(gateway->capture, link, &entry->packet, time);
+                }
+                if(gateway->callback != NULL) {
+                    gateway->callback(gateway->data, link, &entry->packet);
+                }
+            }
+        }
+    }
+    if(length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    // End of file or error: the link is closed and reported to the callback
+    pthread_mutex_lock(&entry->write);
+    close(entry->fd);
+    entry->fd = -1;
+    pthread_mutex_unlock(&entry->write);
+    if(gateway->callback != NULL) {
+        gateway->callback(gateway->data, link, NULL);
+    }
+    return false;
+}
+
+/**
+ * Worker: decode the links with new data.
+ */
+void* gateway_worker(void* arg) {
+    gateway_t* gateway = (gateway_t*) arg;
+    struct epoll_event event;
+    while(gateway->running) {
+        int link;
+        if(epoll_wait(gateway->epoll, &event, 1, GATEWAY_POLL) <= 0) {
+            continue;
+        }
+        link = event.data.u32;
+        // A closed link is not armed again
+        if(gateway_read(gateway, link)) {
+            gateway_arm(gateway, link, EPOLL_CTL_MOD);
+        }
+    }
+    return NULL;
+}
+
+int orb_gateway_start(gateway_t* gateway, unsigned int workers) {
+    if(workers > GATEWAY_WORKERS) {
+        workers = GATEWAY_WORKERS;
+    }
+    gateway->running = true;
+    for(gateway->workers = 0; gateway->workers < workers; gateway->workers++) {
+        if(pthread_create(&gateway->worker[gateway->workers], NULL, gateway_worker, gateway) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int orb_gateway_send(gateway_t* gateway, int link, packet_t* packet) {
+    gateway_link_t* entry;
+    unsigned char buffer[MAX_BUFF_TX + LNG_PACKET_HEADER + LNG_PACKET_INTEGRITY];
+    size_t length, sent = 0;
+    struct timespec now;
+    long long deadline;
+    if(link < 0 || link >= (int) gateway->links) {
+        errno = EINVAL;
+        return -1;
+    }
+    entry = &gateway->link[link];
+    pthread_mutex_lock(&entry->write);
+    if(entry->fd < 0) {
+        pthread_mutex_unlock(&entry->write);
+        errno = EPIPE;
+        return -1;
+    }
+    // Frame with the integrity mode of the link
+    length = orb_build_frame(buffer, packet, entry->integrity);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = now.tv_sec * 1000LL + now.tv_nsec / 1000000 + GATEWAY_SEND;
+    while(sent < length) {
+        ssize_t n = write(entry->fd, buffer + sent, length - sent);
+        if(n < 0) {
+            struct pollfd event = {entry->fd, POLLOUT, 0};
+            long long left;
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno != EAGAIN && errno != EWOULDBLOCK) {
+                break;
+            }
+            // Wait the space in the output queue of the tty until the
+            // deadline, the frame is not mixed with the other writes
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left = deadline - (now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+            if(left <= 0 || poll(&event, 1, left) == 0) {
+                errno = ETIMEDOUT;
+                break;
+            }
+            continue;
+        }
+        sent += n;
+    }
+    pthread_mutex_unlock(&entry->write);
+    if(gateway->capture != NULL) {
+        orb_capture_write(gateway->capture, CAPTURE_RAW_TX, link, buffer, sent, orb_capture_time());
+    }
+    return sent < length ? -1 : 0;
+}
+
+int orb_gateway_mode(gateway_t* gateway, int link, unsigned char integrity) {
+    gateway_link_t* entry;
+    unsigned char modes = SYSTEM_INTEGRITY_SUM | SYSTEM_INTEGRITY_CRC16 | SYSTEM_INTEGRITY_NONE;
+    if(link < 0 || link >= (int) gateway->links
+            || (integrity & modes) == 0 || (integrity & (integrity - 1)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    entry = &gateway->link[link];
+    pthread_mutex_lock(&entry->write);
+    entry->integrity = integrity;
+    entry->pending = integrity;
+    pthread_mutex_unlock(&entry->write);
+    return 0;
+}
+
+void orb_gateway_stop(gateway_t* gateway) {
+    unsigned int i;
+    gateway->running = false;
+    for(i = 0; i < gateway->workers; ++i) {
+        pthread_join(gateway->worker[i], NULL);
+    }
+    gateway->workers = 0;
+    for(i = 0; i < gateway->links; ++i) {
+        if(gateway->link[i].fd >= 0) {
+            close(gateway->link[i].fd);
+        }
+        pthread_mutex_destroy(&gateway->link[i].write);
+    }
+    gateway->links = 0;
+    close(gateway->epoll);
+    gateway->epoll = -1;
+}
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "packet/frame_registry.h"
+#include "or_host/or_index.h"
+
+/******************************************************************************/
+/* Index functions                                                            */
+/******************************************************************************/
+
+/**
+ * Order of the entries: time, then position in the capture.
+ */
+int index_compare(const void* a, const void* b) {
+    const index_entry_t* first = (const index_entry_t*) a;
+    const index_entry_t* second = (const index_entry_t*) b;
+    if(first->time != second->time) {
+        return first->time < second->time ? -1 : 1;
+    }
+    if(first->offset != second->offset) {
+        return first->offset < second->offset ? -1 : 1;
+    }
+    return (int) first->position - (int) second->position;
+}
+
+long orb_index_build(const capture_map_t* capture, const char* path) {
+    index_file_t header;
+    index_entry_t* entry = NULL;
+    size_t number = 0, size = 0, offset = 0;
+    const capture_record_t* record;
+    char temporary[4096];
+    FILE* file;
+
+    while((record = orb_capture_next(capture, &offset)) != NULL) {
+        const unsigned char* data = (const unsigned char*) (record + 1);
+        unsigned int position = 0;
+        if(record->kind != CAPTURE_PACKET) {
+            continue;
+        }
+        while(position + LNG_HEAD_INFORMATION_PACKET <= record->length) {
+            unsigned char length = data[position];
+            // Stop on a message without header or out of the packet
+            if(length < LNG_HEAD_INFORMATION_PACKET || position + length > record->length) {
+                break;
+            }
+            if(number == size) {
+                index_entry_t* grow;
+                size = size == 0 ? 4096 : 2 * size;
+                grow = (index_entry_t*) realloc(entry, size * sizeof(index_entry_t));
+                if(grow == NULL) {
+                    free(entry);
+                    return -1;
+                }
+                entry = grow;
+            }
+            entry[number].time = record->time;
+            entry[number].offset = (const unsigned char*) record - capture->data;
+            entry[number].link = record->link;
+            entry[number].position = position;
+            entry[number].length = length;
+            entry[number].option = data[position + 1];
+            entry[number].type = data[position + 2];
+            entry[number].command = data[position + 3];
+            entry[number].reserved = 0;
+            number++;
+            position += length;
+        }
+    }
+    // The workers of the gateway can write the records out of order
+    qsort(entry, number, sizeof(index_entry_t), index_compare);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.size = sizeof(index_file_t);
+    header.capture = capture->size;
+    header.number = number;
+    // The index is replaced only when completed
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    file = fopen(temporary, "wb");
+    if(file == NULL) {
+        free(entry);
+        return -1;
+    }
+    if(fwrite(&header, sizeof(header), 1, file) != 1
+            || (number > 0 && fwrite(entry, sizeof(index_entry_t), number, file) != number)) {
+        fclose(file);
+        free(entry);
+        unlink(temporary);
+        return -1;
+    }
+    free(entry);
+    if(fclose(file) != 0 || rename(temporary, path) != 0) {
+        unlink(temporary);
+        return -1;
+    }
+    return number;
+}
+
+int orb_index_map(index_map_t* index, const char* path) {
+    struct stat info;
+    void* data;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return -1;
+    }
+    if(fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(index_file_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        return -1;
+    }
+    index->header = (const index_file_t*) data;
+    index->entry = (const index_entry_t*) ((const unsigned char*) data + index->header->size);
+    index->size = info.st_size;
+    if(index->header->magic != INDEX_MAGIC || index->header->version != INDEX_VERSION
+            || index->header->size + index->header->number * sizeof(index_entry_t) > index->size) {
+        orb_index_unmap(index);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void orb_index_unmap(index_map_t* index) {
+    munmap((void*) index->header, index->size);
+    index->header = NULL;
+    index->entry = NULL;
+    index->size = 0;
+}
+
+void orb_index_query_init(index_query_t* query) {
+    query->start = 0;
+    query->end = 0;
+    query->link = INDEX_ANY;
+    query->type = INDEX_ANY;
+    query->command = INDEX_ANY;
+    query->index = INDEX_ANY;
+}
+
+/**
+ * First entry with time not less than time.
+ */
+size_t index_search(const index_map_t* index, uint64_t time) {
+    size_t low = 0, high = index->header->number;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(index->entry[middle].time < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Check if an entry is in the query.
+ */
+bool index_match(const index_query_t* query, const index_entry_t* entry) {
+    int command = entry->command, index = 0;
+    if(query->link != INDEX_ANY && query->link != entry->link) {
+        return false;
+    }
+    if(query->type != INDEX_ANY && query->type != entry->type) {
+        return false;
+    }
+#ifdef HASHMAP_MOTOR
+    if(entry->type == HASHMAP_MOTOR) {
+        command = FRAME_COMMAND_MOTOR(entry->command);
+        index = entry->command & 0x07;
+    }
+#endif
+#ifdef HASHMAP_PERIPHERALS
+    if(entry->type == HASHMAP_PERIPHERALS) {
+        command = FRAME_COMMAND_PERIPHERALS(entry->command);
+        index = entry->command >> 5;
+    }
+#endif
+    if(query->command != INDEX_ANY && query->command != command) {
+        return false;
+    }
+    return query->index == INDEX_ANY || query->index == index;
+}
+
+typedef struct _index_result {
+    const index_entry_t* entry;
+    packet_information_t message;
+} index_result_t;
+
+/**
+ * Slice of the entries in range for a thread.
+ */
+typedef struct _index_slice {
+    const capture_map_t* capture;
+    const index_map_t* index;
+    const index_query_t* query;
+    size_t first;
+    size_t last;
+    index_result_t* result;
+    size_t number;
+    bool error;
+} index_slice_t;
+
+/**
+ * Thread: filter the entries of a slice and read the messages found.
+ */
+void* index_worker(void* arg) {
+    index_slice_t* slice = (index_slice_t*) arg;
+    size_t i, size = 0;
+    for(i = slice->first; i < slice->last; ++i) {
+        const index_entry_t* entry = &slice->index->entry[i];
+        const unsigned char* data;
+        if(!index_match(slice->query, entry)) {
+            continue;
+        }
+        // The capture can be shorter than the capture indexed
+        if(entry->offset + sizeof(capture_record_t) + entry->position + entry->length > slice->capture->size
+                || entry->length > sizeof(packet_information_t)) {
+            continue;
+        }
+        if(slice->number == size) {
+            index_result_t* grow;
+            size = size == 0 ? 256 : 2 * size;
+            grow = (index_result_t*) realloc(slice->result, size * sizeof(index_result_t));
+            if(grow == NULL) {
+                slice->error = true;
+                return NULL;
+            }
+            slice->result = grow;
+        }
+        data = slice->capture->data + entry->offset + sizeof(capture_record_t) + entry->position;
+        slice->result[slice->number].entry = entry;
+        memcpy(&slice->result[slice->number].message, data, entry->length);
+        slice->number++;
+    }
+    return NULL;
+}
+
+long orb_index_query(const capture_map_t* capture, const index_map_t* index, const index_query_t* query,
+        unsigned int threads, index_callback_t callback, void* data) {
+    index_slice_t slice[INDEX_THREADS];
+    pthread_t worker[INDEX_THREADS];
+    bool started[INDEX_THREADS];
+    size_t first = index_search(index, query->start);
+    size_t last = query->end == 0 ? index->header->number : index_search(index, query->end);
+    size_t step, j;
+    unsigned int i;
+    long number = 0;
+    bool error = false;
+
+    if(threads == 0) {
+        threads = 1;
+    }
+    if(threads > INDEX_THREADS) {
+        threads = INDEX_THREADS;
+    }
+    if(last < first) {
+        last = first;
+    }
+    step = (last - first + threads - 1) / threads;
+    for(i = 0; i < threads; ++i) {
+        slice[i].capture = capture;
+        slice[i].index = index;
+        slice[i].query = query;
+        slice[i].first = first + i * step < last ? first + i * step : last;
+        slice[i].last = slice[i].first + step < last ? slice[i].first + step : last;
+        slice[i].result = NULL;
+        slice[i].number = 0;
+        slice[i].error = false;
+        // The first slice runs in the caller thread
+        started[i] = i > 0 && pthread_create(&worker[i], NULL, index_worker, &slice[i]) == 0;
+        if(i > 0 && !started[i]) {
+            index_worker(&slice[i]);
+        }
+    }
+    index_worker(&slice[0]);
+    for(i = 0; i < threads; ++i) {
+        if(started[i]) {
+            pthread_join(worker[i], NULL);
+        }
+        error |= slice[i].error;
+    }
+    // The slices are in order of time
+    for(i = 0; i < threads; ++i) {
+        for(j = 0; j < slice[i].number && !error && callback != NULL; ++j) {
+            callback(data, slice[i].result[j].entry, &slice[i].result[j].message);
+        }
+        number += slice[i].number;
+        free(slice[i].result);
+    }
+    return error ? -1 : number;
+}
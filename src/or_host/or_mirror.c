@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_host/or_mirror.h"
+#include "or_host/or_client.h"
+#include "or_host/or_window.h"
+
+/******************************************************************************/
+/* Mirror functions                                                           */
+/******************************************************************************/
+
+void orb_mirror_init(mirror_t* mirror, mirror_clock_t clock) {
+    mirror->number = 0;
+    mirror->clock = clock;
+}
+
+/**
+ * Find a message in the mirror.
+ * @return the message in the mirror or NULL if the message is not registered
+ */
+mirror_entry_t* mirror_find(mirror_t* mirror, unsigned char type, unsigned char command) {
+    unsigned int i;
+    for(i = 0; i < mirror->number; ++i) {
+        if(mirror->entry[i].type == type && mirror->entry[i].command == command) {
+            return &mirror->entry[i];
+        }
+    }
+    return NULL;
+}
+
+bool orb_mirror_register(mirror_t* mirror, unsigned char type, unsigned char command, unsigned char policy, unsigned int age) {
+    mirror_entry_t* entry = mirror_find(mirror, type, command);
+    if(entry == NULL) {
+        if(mirror->number >= MIRROR_SIZE) {
+            return false;
+        }
+        entry = &mirror->entry[mirror->number++];
+        entry->type = type;
+        entry->command = command;
+        entry->valid = false;
+    }
+    entry->policy = policy;
+    entry->age = age;
+    return true;
+}
+
+bool orb_mirror_read(mirror_t* mirror, unsigned char type, unsigned char command, packet_information_t* message) {
+    mirror_entry_t* entry = mirror_find(mirror, type, command);
+    if(entry == NULL || !entry->valid) {
+        return false;
+    }
+    if(entry->policy == MIRROR_AGE && (unsigned int) (mirror->clock() - entry->time) >= entry->age) {
+        return false;
+    }
+    memcpy(message, &entry->message, entry->message.length);
+    return true;
+}
+
+/**
+ * Save a new value in the mirror.
+ */
+void mirror_save(mirror_t* mirror, mirror_entry_t* entry, packet_information_t* message) {
+    memcpy(&entry->message, message, message->length);
+    entry->message.option = PACKET_DATA;
+    entry->time = mirror->clock();
+    entry->valid = true;
+}
+
+bool orb_mirror_update(mirror_t* mirror, packet_information_t* message) {
+    mirror_entry_t* entry = mirror_find(mirror, message->type, message->command);
+    if(entry == NULL) {
+        return false;
+    }
+    if(message->option == PACKET_DATA) {
+        mirror_save(mirror, entry, message);
+    } else if(message->option == PACKET_NACK) {
+        entry->valid = false;
+    }
+    return true;
+}
+
+/**
+ * Apply a patch (P) to the value in the mirror. Without a value, or with
+ * the bytes out of the message, the board answers with the whole message
+ * or a NACK: the value is invalid until the reply.
+ */
+void mirror_patch(mirror_t* mirror, mirror_entry_t* entry, packet_information_t* message) {
+    message_patch_t* patch = &message->message.patch;
+    if(!entry->valid || patch->length == 0 || patch->length > MAX_BUFF_PATCH
+            || message->length < LNG_HEAD_INFORMATION_PACKET + LNG_MESSAGE_PATCH(patch->length)
+            || patch->offset + patch->length > entry->message.length - LNG_HEAD_INFORMATION_PACKET) {
+        entry->valid = false;
+        return;
+    }
+    memcpy(((unsigned char*) &entry->message.message) + patch->offset, patch->data, patch->length);
+    entry->time = mirror->clock();
+}
+
+bool orb_mirror_write(mirror_t* mirror, packet_information_t* message) {
+    mirror_entry_t* entry = mirror_find(mirror, message->type, message->command);
+    if(entry == NULL) {
+        return false;
+    }
+    if(message->option == PACKET_DATA) {
+        mirror_save(mirror, entry, message);
+    } else if(message->option == PACKET_PATCH) {
+        mirror_patch(mirror, entry, message);
+    }
+    return true;
+}
+
+void orb_mirror_invalidate(mirror_t* mirror, unsigned char type, unsigned char command) {
+    mirror_entry_t* entry = mirror_find(mirror, type, command);
+    if(entry != NULL) {
+        entry->valid = false;
+    }
+}
+
+void orb_mirror_callback(void* data, packet_information_t* message, unsigned char result) {
+    if(result != CLIENT_TIMEOUT) {
+        orb_mirror_update((mirror_t*) data, message);
+    } else if(message->option != PACKET_REQUEST) {
+        // A write without reply can be applied or not on the board
+        orb_mirror_invalidate((mirror_t*) data, message->type, message->command);
+    }
+}
+
+void orb_mirror_window(void* data, packet_information_t* message, unsigned char result) {
+    if(result == WINDOW_NACK || result == WINDOW_TIMEOUT) {
+        orb_mirror_invalidate((mirror_t*) data, message->type, message->command);
+    }
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "or_host/or_ring.h"
+
+#define RING_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RING_STORE(x, value) __atomic_store_n(&(x), (value), __ATOMIC_RELEASE)
+#define RING_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/******************************************************************************/
+/* Ring functions                                                             */
+/******************************************************************************/
+
+/**
+ * Map a ring in shared memory.
+ */
+int ring_map(ring_t* ring, int fd, size_t size, int protection) {
+    void* memory = mmap(NULL, size, protection, MAP_SHARED, fd, 0);
+    close(fd);
+    if(memory == MAP_FAILED) {
+        return -1;
+    }
+    ring->header = (ring_header_t*) memory;
+    ring->slot = (ring_slot_t*) ((unsigned char*) memory + sizeof(ring_header_t));
+    ring->size = size;
+    return 0;
+}
+
+int orb_ring_create(ring_t* ring, const char* name, uint32_t slots) {
+    size_t size = sizeof(ring_header_t) + slots * sizeof(ring_slot_t);
+    int fd;
+    if(slots == 0 || (slots & (slots - 1)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+    if(ftruncate(fd, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    if(ring_map(ring, fd, size, PROT_READ | PROT_WRITE) < 0) {
+        return -1;
+    }
+    memset(ring->slot, 0, slots * sizeof(ring_slot_t));
+    ring->header->slots = slots;
+    ring->header->head = 0;
+    ring->writer = true;
+    // The readers check the magic number after all fields
+    RING_STORE(ring->header->magic, RING_MAGIC);
+    return 0;
+}
+
+int orb_ring_open(ring_t* ring, const char* name) {
+    struct stat info;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0) {
+        return -1;
+    }
+    if(fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(ring_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    if(ring_map(ring, fd, info.st_size, PROT_READ) < 0) {
+        return -1;
+    }
+    ring->writer = false;
+    if(RING_LOAD(ring->header->magic) != RING_MAGIC
+            || sizeof(ring_header_t) + ring->header->slots * sizeof(ring_slot_t) > ring->size) {
+        orb_ring_close(ring, NULL);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void orb_ring_close(ring_t* ring, const char* name) {
+    munmap(ring->header, ring->size);
+    if(ring->writer && name != NULL) {
+        shm_unlink(name);
+    }
+    ring->header = NULL;
+    ring->slot = NULL;
+}
+
+void orb_ring_publish(ring_t* ring, packet_information_t* message) {
+    uint32_t position = ring->header->head;
+    ring_slot_t* slot = &ring->slot[position & (ring->header->slots - 1)];
+    // Odd sequence while the message is not complete
+    RING_STORE(slot->sequence, 2 * position + 1);
+    RING_FENCE();
+    memcpy(&slot->message, message, message->length);
+    RING_STORE(slot->sequence, 2 * (position + 1));
+    RING_STORE(ring->header->head, position + 1);
+}
+
+unsigned int orb_ring_publish_packet(ring_t* ring, packet_t* packet) {
+    unsigned int index = 0, number = 0;
+    while (index < packet->length) {
+        packet_information_t message;
+        unsigned char length = packet->buffer[index];
+        // Stop on a message without header or out of the packet
+        if(length < LNG_HEAD_INFORMATION_PACKET || length > sizeof(packet_information_t)
+                || index + length > packet->length) {
+            break;
+        }
+        memcpy(&message, &packet->buffer[index], length);
+        orb_ring_publish(ring, &message);
+        index += length;
+        number++;
+    }
+    return number;
+}
+
+void orb_ring_reader_init(ring_reader_t* reader, ring_t* ring) {
+    reader->ring = ring;
+    reader->position = RING_LOAD(ring->header->head);
+    reader->lost = 0;
+}
+
+/**
+ * Move a reader after an overrun on the oldest message in the ring.
+ */
+int ring_overrun(ring_reader_t* reader, uint32_t head) {
+    uint32_t oldest = head - reader->ring->header->slots;
+    // The writer can write the oldest message during the read, skip it
+    oldest++;
+    if((int32_t) (oldest - reader->position) > 0) {
+        reader->lost += oldest - reader->position;
+        reader->position = oldest;
+    }
+    return RING_OVERRUN;
+}
+
+int orb_ring_begin(ring_reader_t* reader, const packet_information_t** message) {
+    ring_t* ring = reader->ring;
+    uint32_t head = RING_LOAD(ring->header->head);
+    uint32_t position = reader->position;
+    ring_slot_t* slot;
+    if(head == position) {
+        return RING_EMPTY;
+    }
+    if(head - position > ring->header->slots) {
+        return ring_overrun(reader, head);
+    }
+    slot = &ring->slot[position & (ring->header->slots - 1)];
+    if(RING_LOAD(slot->sequence) != 2 * (position + 1)) {
+        return ring_overrun(reader, RING_LOAD(ring->header->head));
+    }
+    *message = &slot->message;
+    return RING_DATA;
+}
+
+int orb_ring_end(ring_reader_t* reader) {
+    ring_t* ring = reader->ring;
+    uint32_t position = reader->position;
+    ring_slot_t* slot = &ring->slot[position & (ring->header->slots - 1)];
+    RING_FENCE();
+    // The message is overwritten during the read
+    if(RING_LOAD(slot->sequence) != 2 * (position + 1)) {
+        return ring_overrun(reader, RING_LOAD(ring->header->head));
+    }
+    reader->position = position + 1;
+    return RING_DATA;
+}
+
+int orb_ring_read(ring_reader_t* reader, packet_information_t* message) {
+    const packet_information_t* view;
+    unsigned char length;
+    int result = orb_ring_begin(reader, &view);
+    if(result != RING_DATA) {
+        return result;
+    }
+    length = view->length;
+    if(length < LNG_HEAD_INFORMATION_PACKET || length > sizeof(packet_information_t)) {
+        length = sizeof(packet_information_t);
+    }
+    memcpy(message, view, length);
+    return orb_ring_end(reader);
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "or_bus/or_frame.h"
+#include "or_bus/or_message.h"
+#include "or_host/or_transfer.h"
+
+#if FRAME_BLOCK
+
+/**
+ * Replies of the board for a block:
+ * - data of the read and bytes received in the block
+ * - first byte and end of the block
+ * - reply with the state or the check, the last reply of a block
+ * - NACK received
+ */
+typedef struct _transfer {
+    unsigned char* data;
+    uint32_t received;
+    uint32_t offset;
+    uint32_t end;
+    bool done;
+    bool nack;
+    block_state_t state;
+    block_check_t check;
+} transfer_t;
+
+/******************************************************************************/
+/* Transfer functions                                                         */
+/******************************************************************************/
+
+/**
+ * Save the replies of the board for the block in progress.
+ */
+void transfer_reply(void* data, packet_t* packet) {
+    transfer_t* transfer = (transfer_t*) data;
+    unsigned int i = 0;
+    while(i + LNG_HEAD_INFORMATION_PACKET <= packet->length) {
+        packet_information_t* message = (packet_information_t*) &packet->buffer[i];
+        unsigned char length = message->length;
+        if(length < LNG_HEAD_INFORMATION_PACKET || i + length > packet->length || length > sizeof(packet_information_t)) {
+            break;
+        }
+        i += length;
+        if(message->type != HASHMAP_BLOCK) {
+            continue;
+        }
+        if(message->option == PACKET_NACK) {
+            transfer->nack = true;
+            transfer->done = true;
+        } else if(message->option != PACKET_DATA) {
+            continue;
+        }
+        switch(message->command) {
+        case BLOCK_STATE:
+            if(length == LNG_HEAD_INFORMATION_PACKET + LNG_BLOCK_STATE) {
+                memcpy(&transfer->state, &message->message, LNG_BLOCK_STATE);
+                transfer->done = true;
+            }
+            break;
+        case BLOCK_CHUNK:
+            if(transfer->data != NULL && length >= LNG_HEAD_INFORMATION_PACKET + LNG_HEAD_BLOCK_CHUNK) {
+                block_chunk_t chunk;
+                memcpy(&chunk, &message->message, length - LNG_HEAD_INFORMATION_PACKET);
+                if(chunk.length <= length - LNG_HEAD_INFORMATION_PACKET - LNG_HEAD_BLOCK_CHUNK
+                        && chunk.offset >= transfer->offset && chunk.offset + chunk.length <= transfer->end) {
+                    memcpy(&transfer->data[chunk.offset], chunk.data, chunk.length);
+                    transfer->received += chunk.length;
+                }
+            }
+            break;
+        case BLOCK_CHECK:
+            if(length == LNG_HEAD_INFORMATION_PACKET + LNG_BLOCK_CHECK) {
+                memcpy(&transfer->check, &message->message, LNG_BLOCK_CHECK);
+                transfer->done = true;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Time in ms of the monotonic clock.
+ */
+long long transfer_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+/**
+ * Send the messages of a block in the least number of frames and wait the
+ * last reply of the block.
+ * @return 0, -1 on error or timeout (see errno)
+ */
+int transfer_block(transport_t* transport, transfer_t* transfer, packet_information_t** message, size_t number, int timeout) {
+    long long deadline;
+    size_t sent = 0;
+    transfer->received = 0;
+    transfer->done = false;
+    transfer->nack = false;
+    while(sent < number) {
+        int count = orb_transport_send_messages(transport, &message[sent], number - sent);
+        if(count <= 0) {
+            if(count == 0) {
+                errno = EMSGSIZE;
+            }
+            return -1;
+        }
+        sent += count;
+    }
+    deadline = transfer_time() + timeout;
+    while(!transfer->done) {
+        long long left = deadline - transfer_time();
+        if(left <= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if(orb_transport_receive(transport, (int) left, transfer_reply, transfer) < 0) {
+            return -1;
+        }
+    }
+    if(transfer->nack) {
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Send a message of state and wait the reply, again after a timeout: the
+ * state of an area can be requested or written more times.
+ * @return 0, -1 on error or after TRANSFER_RETRY timeouts (see errno)
+ */
+int transfer_state(transport_t* transport, transfer_t* transfer, packet_information_t* message, int timeout) {
+    unsigned int retry = 0;
+    while(transfer_block(transport, transfer, &message, 1, timeout) < 0) {
+        if(errno != ETIMEDOUT || ++retry >= TRANSFER_RETRY) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Length of the block from an offset.
+ */
+uint32_t transfer_length(uint32_t offset, uint32_t size, unsigned int window) {
+    uint32_t length = (window == 0 ? TRANSFER_WINDOW : window);
+    if(length > TRANSFER_WINDOW_MAX) {
+        length = TRANSFER_WINDOW_MAX;
+    }
+    length *= MAX_BUFF_BLOCK_CHUNK;
+    return (size - offset < length) ? size - offset : length;
+}
+
+int orb_transfer_state(transport_t* transport, unsigned char area, int timeout, block_state_t* state) {
+    transfer_t transfer;
+    packet_information_t message;
+    message_abstract_u data;
+    memset(&transfer, 0, sizeof(transfer_t));
+    data.block.state.area = area;
+    message = createPacket(BLOCK_STATE, PACKET_REQUEST, HASHMAP_BLOCK, &data, 1);
+    if(transfer_state(transport, &transfer, &message, timeout) < 0) {
+        return -1;
+    }
+    *state = transfer.state;
+    return 0;
+}
+
+int orb_transfer_write(transport_t* transport, unsigned char area, const void* data, uint32_t size, uint32_t* offset, unsigned int window, int timeout) {
+    const unsigned char* buffer = (const unsigned char*) data;
+    packet_information_t message[TRANSFER_WINDOW_MAX + 1];
+    packet_information_t* list[TRANSFER_WINDOW_MAX + 1];
+    message_abstract_u tail;
+    transfer_t transfer;
+    unsigned int retry = 0;
+    memset(&transfer, 0, sizeof(transfer_t));
+    // Start or resume the transfer
+    tail.block.state.area = area;
+    tail.block.state.size = size;
+    tail.block.state.offset = *offset;
+    message[0] = createPacket(BLOCK_STATE, PACKET_DATA, HASHMAP_BLOCK, &tail, LNG_BLOCK_STATE);
+    if(transfer_state(transport, &transfer, &message[0], timeout) < 0) {
+        return -1;
+    }
+    while(*offset < size) {
+        uint32_t length = transfer_length(*offset, size, window), position = 0;
+        size_t number = 0;
+        while(position < length) {
+            unsigned int chunk = (length - position < MAX_BUFF_BLOCK_CHUNK) ? length - position : MAX_BUFF_BLOCK_CHUNK;
+            tail.block.chunk.offset = *offset + position;
+            tail.block.chunk.length = chunk;
+            memcpy(tail.block.chunk.data, &buffer[*offset + position], chunk);
+            message[number] = createPacket(BLOCK_CHUNK, PACKET_DATA, HASHMAP_BLOCK, &tail, LNG_HEAD_BLOCK_CHUNK + chunk);
+            list[number] = &message[number];
+            number++;
+            position += chunk;
+        }
+        tail.block.check.offset = *offset;
+        tail.block.check.length = length;
+        tail.block.check.crc = orb_integrity_update(SYSTEM_INTEGRITY_CRC16, orb_integrity_init(SYSTEM_INTEGRITY_CRC16), &buffer[*offset], length);
+        message[number] = createPacket(BLOCK_CHECK, PACKET_DATA, HASHMAP_BLOCK, &tail, LNG_BLOCK_CHECK);
+        list[number] = &message[number];
+        number++;
+        if(transfer_block(transport, &transfer, list, number, timeout) < 0) {
+            if(errno != ETIMEDOUT || ++retry >= TRANSFER_RETRY) {
+                return -1;
+            }
+            continue;
+        }
+        // The block is sent again from the offset verified on the board
+        if(transfer.state.offset > *offset) {
+            retry = 0;
+        } else if(++retry >= TRANSFER_RETRY) {
+            errno = EIO;
+            return -1;
+        }
+        *offset = transfer.state.offset;
+    }
+    return 0;
+}
+
+int orb_transfer_read(transport_t* transport, unsigned char area, void* data, uint32_t size, uint32_t* offset, unsigned int window, int timeout) {
+    unsigned char* buffer = (unsigned char*) data;
+    packet_information_t message[TRANSFER_WINDOW_MAX + 1];
+    packet_information_t* list[TRANSFER_WINDOW_MAX + 1];
+    message_abstract_u tail;
+    transfer_t transfer;
+    block_state_t state;
+    unsigned int retry = 0;
+    // Select the area
+    if(orb_transfer_state(transport, area, timeout, &state) < 0) {
+        return -1;
+    }
+    memset(&transfer, 0, sizeof(transfer_t));
+    transfer.data = buffer;
+    while(*offset < size) {
+        uint32_t length = transfer_length(*offset, size, window), position = 0;
+        size_t number = 0;
+        while(position < length) {
+            unsigned int chunk = (length - position < MAX_BUFF_BLOCK_CHUNK) ? length - position : MAX_BUFF_BLOCK_CHUNK;
+            tail.block.chunk.offset = *offset + position;
+            tail.block.chunk.length = chunk;
+            message[number] = createPacket(BLOCK_CHUNK, PACKET_REQUEST, HASHMAP_BLOCK, &tail, LNG_HEAD_BLOCK_CHUNK);
+            list[number] = &message[number];
+            number++;
+            position += chunk;
+        }
+        tail.block.check.offset = *offset;
+        tail.block.check.length = length;
+        tail.block.check.crc = 0;
+        message[number] = createPacket(BLOCK_CHECK, PACKET_REQUEST, HASHMAP_BLOCK, &tail, LNG_BLOCK_CHECK);
+        list[number] = &message[number];
+        number++;
+        transfer.offset = *offset;
+        transfer.end = *offset + length;
+        if(transfer_block(transport, &transfer, list, number, timeout) < 0) {
+            if(errno != ETIMEDOUT || ++retry >= TRANSFER_RETRY) {
+                return -1;
+            }
+            continue;
+        }
+        // All chunks of the block with the check of the board
+        if(transfer.received == length && transfer.check.offset == *offset && transfer.check.length == length
+                && transfer.check.crc == orb_integrity_update(SYSTEM_INTEGRITY_CRC16, orb_integrity_init(SYSTEM_INTEGRITY_CRC16), &buffer[*offset], length)) {
+            *offset += length;
+            retry = 0;
+        } else if(++retry >= TRANSFER_RETRY) {
+            errno = EIO;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif
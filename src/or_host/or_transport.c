@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "or_bus/or_frame.h"
+#include "or_host/or_transport.h"
+
+/******************************************************************************/
+/* Operations on file descriptors                                             */
+/******************************************************************************/
+
+ssize_t fd_writev(transport_t* transport, const struct iovec* vector, int count) {
+    ssize_t length;
+    do {
+        length = writev(transport->fd, vector, count);
+    } while(length < 0 && errno == EINTR);
+    return length;
+}
+
+ssize_t fd_read(transport_t* transport, void* buffer, size_t size) {
+    ssize_t length;
+    do {
+        length = read(transport->fd, buffer, size);
+    } while(length < 0 && errno == EINTR);
+    return length;
+}
+
+int fd_poll(transport_t* transport, int timeout) {
+    struct pollfd event;
+    event.fd = transport->fd;
+    event.events = POLLIN;
+    event.revents = 0;
+    return poll(&event, 1, timeout);
+}
+
+void fd_close(transport_t* transport) {
+    close(transport->fd);
+    transport->fd = -1;
+}
+
+/******************************************************************************/
+/* Serial                                                                     */
+/******************************************************************************/
+
+/**
+ * Speed of the tty from the number of baud.
+ * @return speed or B0 if the tty has not this speed
+ */
+speed_t serial_speed(unsigned long baud) {
+    switch(baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+
+int serial_open(transport_t* transport, const char* address) {
+    char path[4096];
+    unsigned long baud = TRANSPORT_BAUD;
+    const char* speed = strrchr(address, '@');
+    struct termios tty;
+    speed_t rate;
+    size_t length = speed != NULL ? (size_t) (speed - address) : strlen(address);
+    if(length >= sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(path, address, length);
+    path[length] = '\0';
+    if(speed != NULL) {
+        baud = strtoul(speed + 1, NULL, 10);
+    }
+    // A wrong speed is an error, not a link at another speed
+    rate = serial_speed(baud);
+    if(rate == B0) {
+        errno = EINVAL;
+        return -1;
+    }
+    transport->fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if(transport->fd < 0) {
+        return -1;
+    }
+    if(tcgetattr(transport->fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, rate);
+        cfsetospeed(&tty, rate);
+        tty.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(transport->fd, TCSANOW, &tty);
+    }
+    return 0;
+}
+
+const transport_ops_t transport_serial = {serial_open, fd_writev, fd_read, fd_poll, fd_close,
+    SYSTEM_INTEGRITY_SUM | SYSTEM_INTEGRITY_CRC16};
+
+/******************************************************************************/
+/* UNIX socket                                                                */
+/******************************************************************************/
+
+int unix_open(transport_t* transport, const char* address) {
+    struct sockaddr_un name;
+    bool server = address[0] == '+';
+    int fd;
+    if(server) {
+        address++;
+    }
+    if(strlen(address) >= sizeof(name.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&name, 0, sizeof(name));
+    name.sun_family = AF_UNIX;
+    strcpy(name.sun_path, address);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return -1;
+    }
+    if(!server) {
+        if(connect(fd, (struct sockaddr*) &name, sizeof(name)) < 0) {
+            close(fd);
+            return -1;
+        }
+        transport->fd = fd;
+        return 0;
+    }
+    // Wait the connection of a peer
+    unlink(address);
+    if(bind(fd, (struct sockaddr*) &name, sizeof(name)) < 0 || listen(fd, 1) < 0) {
+        close(fd);
+        return -1;
+    }
+    transport->fd = accept(fd, NULL, NULL);
+    close(fd);
+    return transport->fd < 0 ? -1 : 0;
+}
+
+const transport_ops_t transport_unix = {unix_open, fd_writev, fd_read, fd_poll, fd_close,
+    SYSTEM_INTEGRITY_SUM | SYSTEM_INTEGRITY_CRC16 | SYSTEM_INTEGRITY_NONE};
+
+/******************************************************************************/
+/* UDP                                                                        */
+/******************************************************************************/
+
+int udp_open(transport_t* transport, const char* address) {
+    struct addrinfo hints, *peer;
+    struct sockaddr_in local;
+    unsigned int local_port;
+    char host[256], port[16];
+    int fd;
+    if(sscanf(address, "%u@%255[^:]:%15s", &local_port, host, port) != 3) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if(getaddrinfo(host, port, &hints, &peer) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        freeaddrinfo(peer);
+        return -1;
+    }
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(local_port);
+    // A frame is a datagram to the peer
+    if(bind(fd, (struct sockaddr*) &local, sizeof(local)) < 0
+            || connect(fd, peer->ai_addr, peer->ai_addrlen) < 0) {
+        freeaddrinfo(peer);
+        close(fd);
+        return -1;
+    }
+    freeaddrinfo(peer);
+    transport->fd = fd;
+    return 0;
+}
+
+const transport_ops_t transport_udp = {udp_open, fd_writev, fd_read, fd_poll, fd_close,
+    SYSTEM_INTEGRITY_SUM | SYSTEM_INTEGRITY_CRC16 | SYSTEM_INTEGRITY_NONE};
+
+/******************************************************************************/
+/* Transport functions                                                        */
+/******************************************************************************/
+
+int orb_transport_open(transport_t* transport, const transport_ops_t* ops, const char* address) {
+    transport->ops = ops;
+    transport->fd = -1;
+    transport->size = MAX_BUFF_TX;
+    memset(transport->error, 0, sizeof(system_error_serial_t));
+    orb_decoder_init(&transport->decoder, &transport->packet, transport->error);
+    return ops->open(transport, address);
+}
+
+int orb_transport_sendv(transport_t* transport, const struct iovec* segment, int count) {
+    unsigned char header[LNG_PACKET_HEADER], tail[LNG_PACKET_INTEGRITY];
+    unsigned char integrity = transport->decoder.integrity;
+    uint16_t checksum = orb_integrity_init(integrity);
+    struct iovec vector[TRANSPORT_SEGMENTS + 2];
+    size_t length = 0;
+    int i;
+    if(count < 0 || count > TRANSPORT_SEGMENTS) {
+        errno = EINVAL;
+        return -1;
+    }
+    for(i = 0; i < count; ++i) {
+        checksum = orb_integrity_update(integrity, checksum, segment[i].iov_base, segment[i].iov_len);
+        length += segment[i].iov_len;
+        vector[i + 1] = segment[i];
+    }
+    if(length > transport->size) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    header[0] = PACKET_HEADER;
+    header[1] = length;
+    vector[0].iov_base = header;
+    vector[0].iov_len = LNG_PACKET_HEADER;
+    vector[count + 1].iov_base = tail;
+    vector[count + 1].iov_len = orb_integrity_tail(integrity, checksum, tail);
+    length += LNG_PACKET_HEADER + vector[count + 1].iov_len;
+    return transport->ops->writev(transport, vector, count + 2) == (ssize_t) length ? 0 : -1;
+}
+
+int orb_transport_send(transport_t* transport, packet_t* packet) {
+    struct iovec segment;
+    segment.iov_base = packet->buffer;
+    segment.iov_len = packet->length;
+    return orb_transport_sendv(transport, &segment, 1);
+}
+
+int orb_transport_send_messages(transport_t* transport, packet_information_t* const* message, size_t number) {
+    struct iovec segment[TRANSPORT_SEGMENTS];
+    size_t length = 0;
+    int count;
+    for(count = 0; count < TRANSPORT_SEGMENTS && (size_t) count < number; ++count) {
+        // Check if the size can enter in the buffer
+        if(length + message[count]->length > transport->size) {
+            break;
+        }
+        segment[count].iov_base = message[count];
+        segment[count].iov_len = message[count]->length;
+        length += message[count]->length;
+    }
+    // Nothing to send, an empty frame is not written
+    if(count == 0) {
+        if(number > 0) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        return 0;
+    }
+    return orb_transport_sendv(transport, segment, count) < 0 ? -1 : count;
+}
+
+int orb_transport_receive(transport_t* transport, int timeout, transport_callback_t callback, void* data) {
+    unsigned char buffer[TRANSPORT_READ];
+    ssize_t length, i;
+    int number = 0, ready = transport->ops->poll(transport, timeout);
+    if(ready < 0) {
+        // A signal is a wait without data
+        return errno == EINTR ? 0 : -1;
+    }
+    if(ready == 0) {
+        return 0;
+    }
+    length = transport->ops->read(transport, buffer, TRANSPORT_READ);
+    if(length == 0 || (length < 0 && errno != EAGAIN && errno != ECONNREFUSED)) {
+        return -1;
+    }
+    for(i = 0; i < length; ++i) {
+        if(orb_decoder_pkgs(&transport->decoder, buffer[i])) {
+            number++;
+            if(callback != NULL) {
+                callback(data, &transport->packet);
+            }
+        }
+    }
+    return number;
+}
+
+void orb_transport_close(transport_t* transport) {
+    if(transport->fd >= 0) {
+        transport->ops->close(transport);
+    }
+}
+
+/******************************************************************************/
+/* Negotiation                                                                */
+/******************************************************************************/
+
+/**
+ * Reply waited during the negotiation: a system message with a command,
+ * the new integrity mode is used from the bytes after the ACK of
+ * SYSTEM_MODE.
+ */
+typedef struct _transport_reply {
+    transport_t* transport;
+    unsigned char command;
+    unsigned char integrity;
+    bool received;
+    packet_information_t message;
+} transport_reply_t;
+
+void transport_reply(void* data, packet_t* packet) {
+    transport_reply_t* reply = (transport_reply_t*) data;
+    unsigned int i = 0;
+    while(!reply->received && i + LNG_HEAD_INFORMATION_PACKET <= packet->length) {
+        unsigned char length = packet->buffer[i];
+        if(length < LNG_HEAD_INFORMATION_PACKET || i + length > packet->length || length > sizeof(packet_information_t)) {
+            break;
+        }
+        if(packet->buffer[i + 2] == HASHMAP_SYSTEM && packet->buffer[i + 3] == reply->command
+                && packet->buffer[i + 1] != PACKET_REQUEST) {
+            memcpy(&reply->message, &packet->buffer[i], length);
+            reply->received = true;
+            if(reply->command == SYSTEM_MODE && reply->message.option == PACKET_ACK) {
+                reply->transport->decoder.integrity = reply->integrity;
+            }
+        }
+        i += length;
+    }
+}
+
+/**
+ * Send a system message and wait the reply.
+ * @return 0 or -1 on error (see errno)
+ */
+int transport_request(transport_t* transport, transport_reply_t* reply, packet_information_t* message, int timeout) {
+    struct timespec now;
+    long long deadline;
+    reply->transport = transport;
+    reply->command = message->command;
+    reply->received = false;
+    if(orb_transport_send_messages(transport, &message, 1) != 1) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = now.tv_sec * 1000LL + now.tv_nsec / 1000000 + timeout;
+    while(!reply->received) {
+        long long left;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        left = deadline - (now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+        if(left <= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if(orb_transport_receive(transport, (int) left, transport_reply, reply) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Request the capability of the board, in the mode of the link and then in
+ * the other modes: the board can be in the mode of a previous connection or
+ * in the new mode after a lost ACK.
+ * @return 0 or -1 on error (see errno)
+ */
+int transport_probe(transport_t* transport, transport_reply_t* reply, int timeout) {
+    static const unsigned char probe[] = {SYSTEM_INTEGRITY_SUM, SYSTEM_INTEGRITY_CRC16, SYSTEM_INTEGRITY_NONE};
+    packet_information_t message = CREATE_PACKET_RESPONSE(SYSTEM_CAPABILITY, HASHMAP_SYSTEM, PACKET_REQUEST);
+    unsigned char integrity = transport->decoder.integrity;
+    unsigned int i;
+    reply->integrity = integrity;
+    if(transport_request(transport, reply, &message, timeout) == 0) {
+        return 0;
+    }
+    for(i = 0; i < sizeof(probe) && errno == ETIMEDOUT; ++i) {
+        if(probe[i] == integrity) {
+            continue;
+        }
+        transport->decoder.integrity = probe[i];
+        if(transport_request(transport, reply, &message, timeout) == 0) {
+            return 0;
+        }
+    }
+    if(errno == ETIMEDOUT) {
+        transport->decoder.integrity = integrity;
+    }
+    return -1;
+}
+
+int orb_transport_negotiate(transport_t* transport, unsigned char integrity, int timeout, system_capability_t* capability) {
+    // Integrity modes from the fastest
+    static const unsigned char order[] = {SYSTEM_INTEGRITY_NONE, SYSTEM_INTEGRITY_SUM, SYSTEM_INTEGRITY_CRC16};
+    transport_reply_t reply;
+    packet_information_t message;
+    system_capability_t board;
+    system_mode_t mode;
+    message_abstract_u data;
+    unsigned int i;
+    if(transport_probe(transport, &reply, timeout) < 0) {
+        return -1;
+    }
+    // Board without capability
+    if(reply.message.option != PACKET_DATA
+            || reply.message.length != LNG_HEAD_INFORMATION_PACKET + LNG_SYSTEM_CAPABILITY) {
+        return transport->decoder.integrity;
+    }
+    // Without the system family in message_abstract_u
+    memcpy(&board, &reply.message.message, LNG_SYSTEM_CAPABILITY);
+    if(capability != NULL) {
+        *capability = board;
+    }
+    if(board.frame < transport->size) {
+        transport->size = board.frame;
+    }
+    integrity &= board.integrity;
+    for(i = 0; i < sizeof(order) && (integrity & order[i]) == 0; ++i);
+    if(i == sizeof(order) || order[i] == transport->decoder.integrity
+            || (board.framing & SYSTEM_FRAMING_HEADER) == 0) {
+        return transport->decoder.integrity;
+    }
+    mode.integrity = order[i];
+    mode.framing = SYSTEM_FRAMING_HEADER;
+    memcpy(&data, &mode, LNG_SYSTEM_MODE);
+    message = createPacket(SYSTEM_MODE, PACKET_DATA, HASHMAP_SYSTEM, &data, LNG_SYSTEM_MODE);
+    reply.integrity = order[i];
+    if(transport_request(transport, &reply, &message, timeout) < 0) {
+        if(errno != ETIMEDOUT) {
+            return -1;
+        }
+        // The ACK is lost, find the mode of the board
+        if(transport_probe(transport, &reply, timeout) < 0) {
+            return -1;
+        }
+    }
+    return transport->decoder.integrity;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdint.h>        /* Includes uint16_t definition   */
+#include <stdbool.h>       /* Includes true/false definition */
+#include <string.h>
+
+#include "or_host/or_window.h"
+
+#define WINDOW_FREE 0
+#define WINDOW_QUEUED 1
+#define WINDOW_SENT 2
+
+/******************************************************************************/
+/* Window functions                                                           */
+/******************************************************************************/
+
+void orb_window_init(window_t* window, unsigned int timeout, unsigned char transmissions, window_callback_t callback, void* data) {
+    unsigned int i;
+    for(i = 0; i < WINDOW_SIZE; ++i) {
+        window->entry[i].state = WINDOW_FREE;
+    }
+    window->sequence = 0;
+    window->timeout = timeout;
+    window->transmissions = transmissions;
+    window->callback = callback;
+    window->data = data;
+}
+
+/**
+ * Release a write and call the callback with the result.
+ */
+void window_complete(window_t* window, window_entry_t* entry, unsigned char result) {
+    entry->state = WINDOW_FREE;
+    if(window->callback != NULL) {
+        window->callback(window->data, &entry->message, result);
+    }
+}
+
+int orb_window_push(window_t* window, packet_information_t* message) {
+    unsigned int i;
+    window_entry_t* slot = NULL;
+    for(i = 0; i < WINDOW_SIZE; ++i) {
+        window_entry_t* entry = &window->entry[i];
+        if(entry->state == WINDOW_FREE) {
+            if(slot == NULL) {
+                slot = entry;
+            }
+        } else if(entry->message.type == message->type && entry->message.command == message->command) {
+            window_complete(window, entry, WINDOW_SUPERSEDED);
+            if(slot == NULL) {
+                slot = entry;
+            }
+        }
+    }
+    if(slot == NULL) {
+        return -1;
+    }
+    slot->message = *message;
+    slot->sequence = window->sequence++;
+    slot->transmissions = 0;
+    slot->state = WINDOW_QUEUED;
+    return slot->sequence;
+}
+
+/**
+ * Entries in the window from the oldest to the newest sequence number.
+ * @return number of entries
+ */
+unsigned int window_order(window_t* window, window_entry_t** order) {
+    unsigned int i, j, number = 0;
+    for(i = 0; i < WINDOW_SIZE; ++i) {
+        window_entry_t* entry = &window->entry[i];
+        // Age from the next sequence number, the numbers wrap at 256
+        unsigned char age = window->sequence - entry->sequence;
+        if(entry->state == WINDOW_FREE) {
+            continue;
+        }
+        for(j = number; j > 0 && (unsigned char) (window->sequence - order[j - 1]->sequence) < age; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = entry;
+        number++;
+    }
+    return number;
+}
+
+unsigned int orb_window_encode(window_t* window, packet_t* packet, unsigned int now) {
+    window_entry_t* order[WINDOW_SIZE];
+    unsigned int i, number = 0, entries = window_order(window, order);
+    for(i = 0; i < entries; ++i) {
+        window_entry_t* entry = order[i];
+        unsigned char length = entry->message.length;
+        // Retransmit only the writes lost
+        if(entry->state == WINDOW_SENT && (unsigned int) (now - entry->time) < window->timeout) {
+            continue;
+        }
+        if(entry->transmissions >= window->transmissions) {
+            window_complete(window, entry, WINDOW_TIMEOUT);
+            continue;
+        }
+        // Check if the size can enter in the buffer
+        if(packet->length + length + LNG_PACKET_SEQUENCE > MAX_BUFF_TX) {
+            break;
+        }
+        memcpy(&packet->buffer[packet->length], &entry->message, length);
+        packet->buffer[packet->length] = length + LNG_PACKET_SEQUENCE;
+        packet->buffer[packet->length + 1] = PACKET_DATA_SEQ;
+        packet->buffer[packet->length + length] = entry->sequence;
+        packet->length += length + LNG_PACKET_SEQUENCE;
+        entry->transmissions++;
+        entry->time = now;
+        entry->state = WINDOW_SENT;
+        number++;
+    }
+    return number;
+}
+
+bool orb_window_reply(window_t* window, packet_information_t* reply) {
+    unsigned int i;
+    unsigned char sequence;
+    if(reply->length != LNG_HEAD_INFORMATION_PACKET + LNG_PACKET_SEQUENCE
+            || (reply->option != PACKET_ACK && reply->option != PACKET_NACK)) {
+        return false;
+    }
+    sequence = ((unsigned char*) &reply->message)[0];
+    for(i = 0; i < WINDOW_SIZE; ++i) {
+        window_entry_t* entry = &window->entry[i];
+        if(entry->state == WINDOW_SENT && entry->sequence == sequence
+                && entry->message.type == reply->type && entry->message.command == reply->command) {
+            window_complete(window, entry, reply->option == PACKET_ACK ? WINDOW_ACK : WINDOW_NACK);
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int orb_window_pending(window_t* window) {
+    unsigned int i, number = 0;
+    for(i = 0; i < WINDOW_SIZE; ++i) {
+        if(window->entry[i].state != WINDOW_FREE) {
+            number++;
+        }
+    }
+    return number;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Report of the size of all messages and of the buffers of the parser, for
+ * a selection of families (see packet/frame_config.h).
+ * Build on the host with the same preprocessor macros of the board:
+ *      gcc -Iincludes -DFRAME_NAVIGATION=0 tools/frame_report.c -o frame_report
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+
+#include "packet/frame_registry.h"
+#include "or_bus/or_frame.h"
+
+/******************************************************************************/
+/* Report                                                                     */
+/******************************************************************************/
+
+#define REPORT_MESSAGE(command, payload, check) \
+    printf("  %-32s %-34s %3u %s\n", #command, #payload, (unsigned) sizeof(payload), \
+            check == FRAME_CHECK_MAX ? "max" : "");
+#define REPORT_FAMILY(type, messages, map) \
+    printf("[%c] %s\n", type, #messages); \
+    messages(REPORT_MESSAGE)
+
+int main(void) {
+    printf("Families in use: %d\n\n", FRAME_FAMILIES);
+    printf("  %-32s %-34s %3s\n", "command", "data", "size");
+    FRAME_REGISTRY(REPORT_FAMILY)
+    printf("\n");
+    printf("%-40s %5u\n", "message_abstract_u", (unsigned) sizeof(message_abstract_u));
+    printf("%-40s %5u\n", "packet_information_t", (unsigned) sizeof(packet_information_t));
+    printf("%-40s %5u\n", "list to send (BUFFER_LIST_PARSING)", (unsigned) (BUFFER_LIST_PARSING * sizeof(packet_information_t)));
+    printf("%-40s %5u\n", "packet_t", (unsigned) sizeof(packet_t));
+    printf("%-40s %5u\n", "replies in packet (parser_packet)", (unsigned) MAX_BUFF_TX);
+    return 0;
+}
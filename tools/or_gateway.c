@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Gateway for many boards: decodes the packets of all ttys in one process
+ * and forwards them to the local consumers on a UNIX datagram socket, each
+ * datagram is the number of the link and the data of the packet.
+ * With -r the messages of each link are published in a ring in shared
+ * memory, <prefix><link> (see or_host/or_ring.h).
+ * With -c the raw bytes and the packets of all links are appended in a
+ * capture file (see or_host/or_capture.h and tools/or_replay.c).
+ * Without socket, rings and capture the packets are printed on the standard
+ * output.
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_gateway.c src/or_host/or_gateway.c \
+ *          src/or_host/or_ring.c src/or_host/or_capture.c \
+ *          src/or_bus/or_message.c -lpthread -lrt \
+ *          -o or_gateway
+ * Usage:
+ *      or_gateway [-w workers] [-u socket] [-r prefix] [-c capture] /dev/ttyUSB0 ...
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "or_host/or_gateway.h"
+#include "or_host/or_ring.h"
+
+/******************************************************************************/
+/* Consumers                                                                  */
+/******************************************************************************/
+
+typedef struct _consumer {
+    int socket;
+    struct sockaddr_un address;
+    const char* prefix;
+    bool quiet;
+    ring_t ring[GATEWAY_LINKS];
+    pthread_mutex_t print;
+} consumer_t;
+
+volatile sig_atomic_t running = 1;
+
+void stop(int signal) {
+    running = 0;
+}
+
+void forward(void* data, int link, packet_t* packet) {
+    consumer_t* consumer = (consumer_t*) data;
+    unsigned int i;
+    if(packet == NULL) {
+        fprintf(stderr, "link %d: closed\n", link);
+        return;
+    }
+    if(consumer->prefix != NULL) {
+        orb_ring_publish_packet(&consumer->ring[link], packet);
+    }
+    if(consumer->socket >= 0) {
+        unsigned char datagram[MAX_BUFF_RX + 1];
+        datagram[0] = link;
+        memcpy(&datagram[1], packet->buffer, packet->length);
+        sendto(consumer->socket, datagram, packet->length + 1, MSG_DONTWAIT,
+                (struct sockaddr*) &consumer->address, sizeof(consumer->address));
+        return;
+    }
+    if(consumer->prefix != NULL || consumer->quiet) {
+        return;
+    }
+    pthread_mutex_lock(&consumer->print);
+    printf("%d [%u]", link, packet->length);
+    for(i = 0; i < packet->length; ++i) {
+        printf(" %02x", packet->buffer[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+    pthread_mutex_unlock(&consumer->print);
+}
+
+int main(int argc, char** argv) {
+    static gateway_t gateway;
+    consumer_t consumer;
+    unsigned int workers = 4, links, i;
+    int option, link;
+
+    char name[64];
+    const char* path = NULL;
+    capture_t capture;
+
+    consumer.socket = -1;
+    consumer.prefix = NULL;
+    consumer.quiet = false;
+    pthread_mutex_init(&consumer.print, NULL);
+    while((option = getopt(argc, argv, "w:u:r:c:")) != -1) {
+        switch(option) {
+        case 'w':
+            workers = atoi(optarg);
+            break;
+        case 'u':
+            consumer.socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+            memset(&consumer.address, 0, sizeof(consumer.address));
+            consumer.address.sun_family = AF_UNIX;
+            strncpy(consumer.address.sun_path, optarg, sizeof(consumer.address.sun_path) - 1);
+            break;
+        case 'r':
+            consumer.prefix = optarg;
+            break;
+        case 'c':
+            path = optarg;
+            consumer.quiet = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-w workers] [-u socket] [-r prefix] [-c capture] tty...\n", argv[0]);
+            return 1;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "Usage: %s [-w workers] [-u socket] [-r prefix] [-c capture] tty...\n", argv[0]);
+        return 1;
+    }
+    if(orb_gateway_init(&gateway, forward, &consumer) < 0) {
+        perror("epoll");
+        return 1;
+    }
+    if(path != NULL) {
+        if(orb_capture_open(&capture, path) < 0) {
+            perror(path);
+            return 1;
+        }
+        gateway.capture = &capture;
+    }
+    for(i = optind; i < (unsigned int) argc; ++i) {
+        if((link = orb_gateway_open(&gateway, argv[i], B115200)) < 0) {
+            perror(argv[i]);
+            return 1;
+        }
+        if(consumer.prefix != NULL) {
+            snprintf(name, sizeof(name), "%s%d", consumer.prefix, link);
+            if(orb_ring_create(&consumer.ring[link], name, RING_SLOTS) < 0) {
+                perror(name);
+                return 1;
+            }
+        }
+        fprintf(stderr, "link %d: %s\n", link, argv[i]);
+    }
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    if(orb_gateway_start(&gateway, workers) < 0) {
+        perror("workers");
+        orb_gateway_stop(&gateway);
+        return 1;
+    }
+    while(running) {
+        pause();
+    }
+    // Errors of the decoders before to close the links
+    links = gateway.links;
+    for(i = 0; i < links; ++i) {
+        fprintf(stderr, "link %u: checksum errors %d, header errors %d\n", i,
+                gateway.link[i].error[-ERROR_CKS - 1], gateway.link[i].error[-ERROR_HEADER - 1]);
+    }
+    orb_gateway_stop(&gateway);
+    for(i = 0; consumer.prefix != NULL && i < links; ++i) {
+        snprintf(name, sizeof(name), "%s%u", consumer.prefix, i);
+        orb_ring_close(&consumer.ring[i], name);
+    }
+    if(path != NULL) {
+        orb_capture_close(&capture);
+    }
+    return 0;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Benchmark of the worst case time of the decoder and of the parser, for
+ * the budgets of the serial interrupt. Each call is timed: decode_pkgs in
+ * each state of the decoder, with frames of MAX_BUFF_RX bytes (the checksum
+ * is updated on each data byte, the last byte compares it with the tail),
+ * and parser_packet with worst case packets. For each case are printed
+ * p50, p99, p99.9 and max (ns).
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_latency.c src/or_bus/or_message.c \
+ *          src/or_bus/or_frame.c src/or_bus/or_registry.c -o or_latency
+ * Usage, fail if the max time of the checksum byte is over 2000 ns:
+ *      or_latency [-n frames] [-p] [-b checksum=2000] [-b parser-requests=50000]
+ * Cases: header, length, data, checksum, parser-requests, parser-data,
+ * parser-patch, a budget of another case is an error of usage. The exit
+ * status is 1 if a budget is exceeded. The max time includes the
+ * preemptions of the host: run on an isolated core (taskset -c 3
+ * or_latency) or check the budgets on p99.9 with -p.
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "packet/frame_registry.h"
+#include "or_bus/or_frame.h"
+#include "or_bus/or_message.h"
+#include "or_bus/or_registry.h"
+
+// Max number of budgets
+#define LATENCY_BUDGETS 16
+
+// Names of the cases, for the budgets
+const char* cases[] = {"header", "length", "data", "checksum",
+    "parser-requests", "parser-data", "parser-patch", NULL};
+
+/******************************************************************************/
+/* Measures                                                                   */
+/******************************************************************************/
+
+typedef struct _sample {
+    const char* name;
+    unsigned long* time;
+    size_t number;
+    size_t size;
+} sample_t;
+
+typedef struct _budget {
+    const char* name;
+    unsigned long max;
+} budget_t;
+
+message_abstract_u store;
+
+static inline unsigned long now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return time.tv_sec * 1000000000UL + time.tv_nsec;
+}
+
+void sample_init(sample_t* sample, const char* name, size_t size) {
+    sample->name = name;
+    sample->time = (unsigned long*) malloc(size * sizeof(unsigned long));
+    sample->number = 0;
+    sample->size = size;
+}
+
+static inline void sample_add(sample_t* sample, unsigned long time) {
+    if(sample->number < sample->size) {
+        sample->time[sample->number++] = time;
+    }
+}
+
+int compare(const void* a, const void* b) {
+    unsigned long first = *(const unsigned long*) a, second = *(const unsigned long*) b;
+    return first < second ? -1 : first > second;
+}
+
+/**
+ * Print the distribution of a case and check its budget.
+ * @return false if the max time (or p99.9) is over the budget
+ */
+bool sample_report(sample_t* sample, unsigned long overhead, budget_t* budget, unsigned int budgets, bool percentile) {
+    unsigned long p50, p99, p999, max;
+    unsigned int i;
+    bool ok = true;
+    size_t j;
+    if(sample->number == 0) {
+        return true;
+    }
+    for(j = 0; j < sample->number; ++j) {
+        sample->time[j] = sample->time[j] > overhead ? sample->time[j] - overhead : 0;
+    }
+    qsort(sample->time, sample->number, sizeof(unsigned long), compare);
+    p50 = sample->time[sample->number / 2];
+    p99 = sample->time[(size_t) (sample->number * 0.99)];
+    p999 = sample->time[(size_t) (sample->number * 0.999)];
+    max = sample->time[sample->number - 1];
+    printf("%-16s %9zu %8lu %8lu %8lu %8lu", sample->name, sample->number, p50, p99, p999, max);
+    for(i = 0; i < budgets; ++i) {
+        if(strcmp(budget[i].name, sample->name) == 0) {
+            ok = (percentile ? p999 : max) <= budget[i].max;
+            printf("  budget %lu %s", budget[i].max, ok ? "ok" : "EXCEEDED");
+        }
+    }
+    printf("\n");
+    free(sample->time);
+    return ok;
+}
+
+packet_information_t send_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u message) {
+    int index = orb_registry_index(type, command);
+    if(index == REGISTRY_UNKNOWN) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    return createPacket(command, PACKET_DATA, type, &store, orb_registry_size(index));
+}
+
+packet_information_t receive_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u message) {
+    store = message;
+    return CREATE_PACKET_ACK(command, type);
+}
+
+/**
+ * Fill a packet with the same message.
+ */
+void fill(packet_t* packet, packet_information_t* message) {
+    packet->length = 0;
+    while(packet->length + message->length <= MAX_BUFF_RX) {
+        memcpy(&packet->buffer[packet->length], message, message->length);
+        packet->length += message->length;
+    }
+}
+
+/**
+ * Command on the wire of a message in registry, with index 0.
+ */
+unsigned char command_byte(unsigned char type, unsigned char command) {
+#ifdef HASHMAP_MOTOR
+    if(type == HASHMAP_MOTOR) {
+        return FRAME_INDEX_MOTOR(command, 0);
+    }
+#endif
+#ifdef HASHMAP_PERIPHERALS
+    if(type == HASHMAP_PERIPHERALS) {
+        return FRAME_INDEX_PERIPHERALS(command, 0);
+    }
+#endif
+    return command;
+}
+
+/**
+ * The largest message with data in registry.
+ */
+packet_information_t largest(void) {
+    packet_information_t message = CREATE_PACKET_EMPTY;
+    unsigned char family = 0;
+    size_t size = 0;
+#define LATENCY_MESSAGE(command, payload, check) \
+    if(sizeof(payload) > size && sizeof(payload) <= sizeof(message_abstract_u)) { \
+        size = sizeof(payload); \
+        message = createPacket(command_byte(family, command), PACKET_DATA, family, &store, size); \
+    }
+#define LATENCY_FAMILY(type, messages, map) family = type; messages(LATENCY_MESSAGE)
+    FRAME_REGISTRY(LATENCY_FAMILY)
+    return message;
+}
+
+void parse(sample_t* sample, packet_t* packet) {
+    packet_t send;
+    unsigned long start = now();
+    bool done = parser_packet(packet, &send);
+    while(!done) {
+        send.length = 0;
+        done = parser_resume_packet(&send, 0, NULL, 0);
+    }
+    sample_add(sample, now() - start);
+}
+
+int main(int argc, char** argv) {
+    sample_t header, length, data, checksum, requests, writes, patches;
+    budget_t budget[LATENCY_BUDGETS];
+    unsigned int budgets = 0, frames = 100000, i;
+    unsigned long overhead = ~0UL, start;
+    unsigned char buffer[MAX_BUFF_RX + LNG_PACKET_HEADER + 1];
+    packet_t receive, frame, request, write, patch;
+    packet_information_t message;
+    bool ok = true, percentile = false;
+    int option;
+    size_t j;
+
+    while((option = getopt(argc, argv, "n:pb:")) != -1) {
+        switch(option) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 'p':
+            percentile = true;
+            break;
+        case 'b':
+            if(budgets >= LATENCY_BUDGETS || strchr(optarg, '=') == NULL) {
+                fprintf(stderr, "Usage: %s [-n frames] [-p] [-b case=ns] ...\n", argv[0]);
+                return 1;
+            }
+            *strchr(optarg, '=') = '\0';
+            for(i = 0; cases[i] != NULL && strcmp(cases[i], optarg) != 0; ++i);
+            if(cases[i] == NULL) {
+                fprintf(stderr, "%s: unknown case %s\n", argv[0], optarg);
+                fprintf(stderr, "Usage: %s [-n frames] [-p] [-b case=ns] ...\n", argv[0]);
+                return 1;
+            }
+            budget[budgets].name = optarg;
+            budget[budgets].max = strtoul(optarg + strlen(optarg) + 1, NULL, 10);
+            budgets++;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n frames] [-p] [-b case=ns] ...\n", argv[0]);
+            return 1;
+        }
+    }
+    memset(&store, 0x55, sizeof(store));
+    orb_frame_init();
+    orb_message_init(&receive);
+#define LATENCY_READER(type, messages, map) set_frame_reader(type, send_frame, receive_frame);
+    FRAME_REGISTRY(LATENCY_READER)
+
+    // Overhead of the timer
+    for(i = 0; i < 100000; ++i) {
+        start = now();
+        start = now() - start;
+        overhead = start < overhead ? start : overhead;
+    }
+
+    // Decoder: a frame with MAX_BUFF_RX bytes of data
+    frame.length = MAX_BUFF_RX;
+    for(j = 0; j < MAX_BUFF_RX; ++j) {
+        frame.buffer[j] = j;
+    }
+    build_pkg(buffer, frame);
+    sample_init(&header, "header", frames);
+    sample_init(&length, "length", frames);
+    sample_init(&data, "data", frames * 4);
+    sample_init(&checksum, "checksum", frames);
+    for(i = 0; i < frames; ++i) {
+        for(j = 0; j < MAX_BUFF_RX + LNG_PACKET_HEADER + 1; ++j) {
+            unsigned long time;
+            start = now();
+            decode_pkgs(buffer[j]);
+            time = now() - start;
+            if(j == 0) {
+                sample_add(&header, time);
+            } else if(j == 1) {
+                sample_add(&length, time);
+            } else if(j == MAX_BUFF_RX + LNG_PACKET_HEADER) {
+                sample_add(&checksum, time);
+            } else if(j % 50 == 0) {
+                sample_add(&data, time);
+            }
+        }
+    }
+
+    // Parser: a packet full of requests, of the largest data and of patches
+    message = largest();
+    message.option = PACKET_REQUEST;
+    message.length = LNG_HEAD_INFORMATION_PACKET;
+    fill(&request, &message);
+    message = largest();
+    fill(&write, &message);
+    message = largest();
+    message = createPatchPacket(message.command, message.type, 0, &store, MAX_BUFF_PATCH);
+    fill(&patch, &message);
+    sample_init(&requests, "parser-requests", frames);
+    sample_init(&writes, "parser-data", frames);
+    sample_init(&patches, "parser-patch", frames);
+    for(i = 0; i < frames; ++i) {
+        parse(&requests, &request);
+        parse(&writes, &write);
+        parse(&patches, &patch);
+    }
+
+    printf("timer overhead %lu ns (removed)\n", overhead);
+    printf("%-16s %9s %8s %8s %8s %8s\n", "case", "calls", "p50", "p99", "p99.9", "max");
+    ok &= sample_report(&header, overhead, budget, budgets, percentile);
+    ok &= sample_report(&length, overhead, budget, budgets, percentile);
+    ok &= sample_report(&data, overhead, budget, budgets, percentile);
+    ok &= sample_report(&checksum, overhead, budget, budgets, percentile);
+    ok &= sample_report(&requests, overhead, budget, budgets, percentile);
+    ok &= sample_report(&writes, overhead, budget, budgets, percentile);
+    ok &= sample_report(&patches, overhead, budget, budgets, percentile);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Query of a capture file (see or_host/or_capture.h) with its index
+ * <capture>.idx, built again when the capture grows.
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_query.c src/or_host/or_index.c \
+ *          src/or_host/or_capture.c -lpthread -o or_query
+ * Usage, all MOTOR_DIAGNOSTIC of motor 2 between t1 and t2 (ns):
+ *      or_query -f G -c 3 -m 2 -s t1 -e t2 [-l link] [-j threads] [-q] capture
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "or_host/or_index.h"
+
+/******************************************************************************/
+/* Query                                                                      */
+/******************************************************************************/
+
+void print(void* data, const index_entry_t* entry, packet_information_t* message) {
+    unsigned int i;
+    if(*(bool*) data) {
+        return;
+    }
+    printf("%llu %u %c %c %3u [%2u]", (unsigned long long) entry->time, entry->link,
+            message->option, message->type, message->command, message->length);
+    for(i = LNG_HEAD_INFORMATION_PACKET; i < message->length; ++i) {
+        printf(" %02x", ((unsigned char*) message)[i]);
+    }
+    printf("\n");
+}
+
+double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+int main(int argc, char** argv) {
+    capture_map_t capture;
+    index_map_t index;
+    index_query_t query;
+    unsigned int threads = 4;
+    char path[4096];
+    bool quiet = false, valid;
+    double start;
+    long number;
+    int option;
+
+    orb_index_query_init(&query);
+    while((option = getopt(argc, argv, "f:c:m:l:s:e:j:q")) != -1) {
+        switch(option) {
+        case 'f':
+            query.type = optarg[0];
+            break;
+        case 'c':
+            query.command = atoi(optarg);
+            break;
+        case 'm':
+            query.index = atoi(optarg);
+            break;
+        case 'l':
+            query.link = atoi(optarg);
+            break;
+        case 's':
+            query.start = strtoull(optarg, NULL, 10);
+            break;
+        case 'e':
+            query.end = strtoull(optarg, NULL, 10);
+            break;
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 'q':
+            quiet = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-f type] [-c command] [-m index] [-l link] [-s start] [-e end] [-j threads] [-q] capture\n", argv[0]);
+            return 1;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "Usage: %s [-f type] [-c command] [-m index] [-l link] [-s start] [-e end] [-j threads] [-q] capture\n", argv[0]);
+        return 1;
+    }
+    if(orb_capture_map(&capture, argv[optind]) < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s.idx", argv[optind]);
+    // Build the index again if the capture grows
+    valid = orb_index_map(&index, path) == 0;
+    if(valid && index.header->capture != capture.size) {
+        orb_index_unmap(&index);
+        valid = false;
+    }
+    if(!valid) {
+        start = now();
+        number = orb_index_build(&capture, path);
+        if(number < 0 || orb_index_map(&index, path) < 0) {
+            perror(path);
+            return 1;
+        }
+        fprintf(stderr, "index: %ld messages in %.1f ms\n", number, now() - start);
+    }
+    start = now();
+    number = orb_index_query(&capture, &index, &query, threads, print, &quiet);
+    fprintf(stderr, "query: %ld messages in %.1f ms\n", number, now() - start);
+    orb_index_unmap(&index);
+    orb_capture_unmap(&capture);
+    return number < 0 ? 1 : 0;
+}
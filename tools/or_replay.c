@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Replay of a capture file (see or_host/or_capture.h): the raw bytes
+ * received are decoded with a decoder for each link and the packets are
+ * parsed, as fast as possible or in real time (-t). With -p the packets
+ * decoded in the capture are parsed without decoding. The frames are read
+ * from a reader for each family, that replies as a board: a request with
+ * the message (zero), a write with an ACK. The decoder of a link follows
+ * the changes of integrity mode recorded in the capture (CAPTURE_MODE).
+ * A capture is a reproducible input for benchmarks of decoder and parser.
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_replay.c src/or_host/or_capture.c \
+ *          src/or_bus/or_message.c src/or_bus/or_frame.c \
+ *          src/or_bus/or_registry.c -lpthread -o or_replay
+ * Usage:
+ *      or_replay [-t] [-p] [-n repeat] capture
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "packet/frame_registry.h"
+#include "or_bus/or_frame.h"
+#include "or_bus/or_message.h"
+#include "or_bus/or_registry.h"
+#include "or_host/or_capture.h"
+
+// Max number of links in a capture
+#define REPLAY_LINKS 256
+
+/******************************************************************************/
+/* Replay                                                                     */
+/******************************************************************************/
+
+typedef struct _replay {
+    decoder_t decoder[REPLAY_LINKS];
+    packet_t packet[REPLAY_LINKS];
+    system_error_serial_t error;
+    packet_t send;
+    unsigned long packets;
+    unsigned long bytes;
+    unsigned long replies;
+} replay_t;
+
+uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+packet_information_t send_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u data) {
+    int index = orb_registry_index(type, command);
+    message_abstract_u zero;
+    if(index == REGISTRY_UNKNOWN) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    memset(&zero, 0, sizeof(zero));
+    return createPacket(command, PACKET_DATA, type, &zero, orb_registry_size(index));
+}
+
+packet_information_t receive_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u data) {
+    return CREATE_PACKET_ACK(command, type);
+}
+
+void parse(replay_t* replay, packet_t* packet) {
+    bool done = parser_packet(packet, &replay->send);
+    replay->replies += replay->send.length;
+    while(!done) {
+        replay->send.length = 0;
+        done = parser_resume_packet(&replay->send, 0, NULL, 0);
+        replay->replies += replay->send.length;
+    }
+    replay->packets++;
+}
+
+int main(int argc, char** argv) {
+    static replay_t replay;
+    capture_map_t map;
+    const capture_record_t* record;
+    bool realtime = false, packets = false;
+    unsigned int repeat = 1, i, n;
+    uint64_t begin, start, first = 0, elapsed;
+    int option;
+
+    while((option = getopt(argc, argv, "tpn:")) != -1) {
+        switch(option) {
+        case 't':
+            realtime = true;
+            break;
+        case 'p':
+            packets = true;
+            break;
+        case 'n':
+            repeat = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t] [-p] [-n repeat] capture\n", argv[0]);
+            return 1;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "Usage: %s [-t] [-p] [-n repeat] capture\n", argv[0]);
+        return 1;
+    }
+    if(orb_capture_map(&map, argv[optind]) < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    orb_frame_init();
+#define REPLAY_FAMILY(type, messages, map) set_frame_reader(type, send_frame, receive_frame);
+    FRAME_REGISTRY(REPLAY_FAMILY)
+    begin = start = now();
+    for(n = 0; n < repeat; ++n) {
+        size_t offset = 0;
+        // Each pass starts as the capture, with the links in SUM
+        for(i = 0; i < REPLAY_LINKS; ++i) {
+            orb_decoder_init(&replay.decoder[i], &replay.packet[i], replay.error);
+        }
+        while((record = orb_capture_next(&map, &offset)) != NULL) {
+            const unsigned char* data = (const unsigned char*) (record + 1);
+            if(record->link >= REPLAY_LINKS) {
+                continue;
+            }
+            if(realtime) {
+                uint64_t wait;
+                if(first == 0) {
+                    first = record->time;
+                }
+                wait = record->time - first;
+                elapsed = now() - start;
+                if(wait > elapsed) {
+                    usleep((wait - elapsed) / 1000);
+                }
+            }
+            if(record->kind == CAPTURE_MODE && record->length == 1) {
+                replay.decoder[record->link].integrity = data[0];
+            } else if(!packets && record->kind == CAPTURE_RAW_RX) {
+                replay.bytes += record->length;
+                for(i = 0; i < record->length; ++i) {
+                    if(orb_decoder_pkgs(&replay.decoder[record->link], data[i])) {
+                        parse(&replay, &replay.packet[record->link]);
+                    }
+                }
+            } else if(packets && record->kind == CAPTURE_PACKET && record->length <= MAX_BUFF_RX) {
+                packet_t packet;
+                packet.length = record->length;
+                memcpy(packet.buffer, data, record->length);
+                replay.bytes += record->length;
+                parse(&replay, &packet);
+            }
+        }
+        first = 0;
+        start = now();
+    }
+    elapsed = now() - begin;
+    printf("bytes %lu, packets %lu, replies %lu bytes\n", replay.bytes, replay.packets, replay.replies);
+    printf("time %.3f ms, %.1f packets/s, %.2f MB/s\n", elapsed / 1e6,
+            replay.packets / (elapsed / 1e9), replay.bytes / (elapsed / 1e3));
+    printf("checksum errors %d, header errors %d\n", replay.error[-ERROR_CKS - 1], replay.error[-ERROR_HEADER - 1]);
+    orb_capture_unmap(&map);
+    return 0;
+}
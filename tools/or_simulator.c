@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Simulator of boards behind pseudo-terminals, for load tests of the host
+ * without boards. Each board is a process with the device side of the
+ * library (orb_message_init, decode_pkgs, parser_packet and a frame reader
+ * for each family in packet/frame_registry.h). A board replies with the
+ * last data written for each message, or with zeros. Each board has an
+ * area of SIMULATOR_AREA bytes in RAM for the block transfer (area 0) and
+ * negotiates the integrity modes in MESSAGE_INTEGRITY.
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_simulator.c src/or_bus/or_message.c \
+ *          src/or_bus/or_frame.c src/or_bus/or_registry.c src/or_bus/or_block.c \
+ *          -o or_simulator
+ * Usage, 8 boards at 115200 baud with 500 us of latency and 1% of replies
+ * with a wrong checksum:
+ *      or_simulator -n 8 -b 115200 -l 500 -e 0.01 [-d drop] [-s seed]
+ * The paths of the pseudo-terminals are printed on the standard output.
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "packet/frame_registry.h"
+#include "or_bus/or_frame.h"
+#include "or_bus/or_message.h"
+#include "or_bus/or_registry.h"
+#include "or_bus/or_block.h"
+
+// Max number of boards
+#define SIMULATOR_BOARDS 256
+// Max number of messages written in a board
+#define SIMULATOR_MESSAGES 128
+// Size of the area for block transfer
+#define SIMULATOR_AREA 65536
+
+/******************************************************************************/
+/* Board                                                                      */
+/******************************************************************************/
+
+typedef struct _simulator {
+    unsigned int baud;
+    unsigned int latency;
+    double corrupt;
+    double drop;
+} simulator_t;
+
+typedef struct _message {
+    unsigned char type;
+    unsigned char command;
+    message_abstract_u message;
+} message_t;
+
+simulator_t simulator = {0, 0, 0, 0};
+message_t message[SIMULATOR_MESSAGES];
+unsigned int messages = 0;
+int board = 0;
+unsigned char area[SIMULATOR_AREA];
+
+message_t* find(unsigned char type, unsigned char command) {
+    unsigned int i;
+    for(i = 0; i < messages; ++i) {
+        if(message[i].type == type && message[i].command == command) {
+            return &message[i];
+        }
+    }
+    return NULL;
+}
+
+packet_information_t send_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u data) {
+    int index = orb_registry_index(type, command);
+    message_t* entry = find(type, command);
+    message_abstract_u zero;
+    if(index == REGISTRY_UNKNOWN) {
+        return CREATE_PACKET_NACK(command, type);
+    }
+    if(entry == NULL) {
+        memset(&zero, 0, sizeof(zero));
+#ifdef HASHMAP_SYSTEM
+        if(type == HASHMAP_SYSTEM && command == SYSTEM_CODE_BOARD_NAME) {
+            snprintf((char*) &zero, sizeof(system_service_t), "sim%d", board);
+        }
+#endif
+        return createPacket(command, PACKET_DATA, type, &zero, orb_registry_size(index));
+    }
+    return createPacket(command, PACKET_DATA, type, &entry->message, orb_registry_size(index));
+}
+
+packet_information_t receive_frame(unsigned char option, unsigned char type, unsigned char command, message_abstract_u data) {
+    message_t* entry = find(type, command);
+    if(entry == NULL) {
+        if(messages >= SIMULATOR_MESSAGES) {
+            return CREATE_PACKET_NACK(command, type);
+        }
+        entry = &message[messages++];
+        entry->type = type;
+        entry->command = command;
+    }
+    entry->message = data;
+    return CREATE_PACKET_ACK(command, type);
+}
+
+bool area_read(uint32_t offset, unsigned char* data, unsigned int length) {
+    memcpy(data, &area[offset], length);
+    return true;
+}
+
+bool area_write(uint32_t offset, const unsigned char* data, unsigned int length) {
+    memcpy(&area[offset], data, length);
+    return true;
+}
+
+void reply(int fd, packet_t* packet) {
+    unsigned char buffer[MAX_BUFF_TX + LNG_PACKET_HEADER + LNG_PACKET_INTEGRITY];
+    size_t length, sent = 0;
+    if(packet->length == 0 || drand48() < simulator.drop) {
+        return;
+    }
+    // Frame in the mode of the link, a new mode is used after this frame
+    length = orb_build_pkg(buffer, packet);
+    if(drand48() < simulator.corrupt) {
+        buffer[length - 1] ^= 0x5A;
+    }
+    if(simulator.latency > 0) {
+        usleep(simulator.latency);
+    }
+    while(sent < length) {
+        ssize_t n = write(fd, buffer + sent, length - sent);
+        if(n <= 0) {
+            return;
+        }
+        sent += n;
+    }
+    // 10 bits for each byte on the serial line
+    if(simulator.baud > 0) {
+        usleep(length * 10 * 1000000ULL / simulator.baud);
+    }
+}
+
+void run(int fd) {
+    packet_t receive, send;
+    unsigned char buffer[256];
+    ssize_t length, i;
+
+    orb_frame_init();
+    orb_message_init(&receive);
+    orb_message_negotiate(MESSAGE_INTEGRITY);
+#define SIMULATOR_FAMILY(type, messages, map) set_frame_reader(type, send_frame, receive_frame);
+    FRAME_REGISTRY(SIMULATOR_FAMILY)
+#if FRAME_BLOCK
+    orb_block_init();
+    orb_block_area(0, SIMULATOR_AREA, area_read, area_write);
+#endif
+    while((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        // The bytes received on the serial line
+        if(simulator.baud > 0) {
+            usleep(length * 10 * 1000000ULL / simulator.baud);
+        }
+        for(i = 0; i < length; ++i) {
+            if(decode_pkgs(buffer[i])) {
+                bool done = parser_packet(&receive, &send);
+                reply(fd, &send);
+                while(!done) {
+                    send.length = 0;
+                    done = parser_resume_packet(&send, 0, NULL, 0);
+                    reply(fd, &send);
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+/* Simulator                                                                  */
+/******************************************************************************/
+
+volatile sig_atomic_t running = 1;
+
+void stop(int signal) {
+    running = 0;
+}
+
+int main(int argc, char** argv) {
+    pid_t child[SIMULATOR_BOARDS];
+    int master[SIMULATOR_BOARDS];
+    unsigned int boards = 1, started = 0, i;
+    long seed = 1;
+    int option;
+
+    while((option = getopt(argc, argv, "n:b:l:e:d:s:")) != -1) {
+        switch(option) {
+        case 'n':
+            boards = atoi(optarg);
+            break;
+        case 'b':
+            simulator.baud = atoi(optarg);
+            break;
+        case 'l':
+            simulator.latency = atoi(optarg);
+            break;
+        case 'e':
+            simulator.corrupt = atof(optarg);
+            break;
+        case 'd':
+            simulator.drop = atof(optarg);
+            break;
+        case 's':
+            seed = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n boards] [-b baud] [-l latency] [-e corrupt] [-d drop] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(boards == 0 || boards > SIMULATOR_BOARDS) {
+        fprintf(stderr, "boards: 1 to %d\n", SIMULATOR_BOARDS);
+        return 1;
+    }
+    for(i = 0; i < boards; ++i) {
+        struct termios tty;
+        master[i] = posix_openpt(O_RDWR | O_NOCTTY);
+        if(master[i] < 0 || grantpt(master[i]) < 0 || unlockpt(master[i]) < 0) {
+            perror("pty");
+            return 1;
+        }
+        if(tcgetattr(master[i], &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(master[i], TCSANOW, &tty);
+        }
+        printf("%s\n", ptsname(master[i]));
+    }
+    fflush(stdout);
+    // A process for each board, the device side of the library uses globals
+    for(i = 0; i < boards; ++i) {
+        child[i] = fork();
+        if(child[i] < 0) {
+            // Stop the boards already started, without kill(-1)
+            perror("fork");
+            running = 0;
+            break;
+        }
+        if(child[i] == 0) {
+            // Keep the pty open without the host
+            int slave = open(ptsname(master[i]), O_RDWR | O_NOCTTY);
+            signal(SIGINT, SIG_DFL);
+            board = i;
+            srand48(seed + i);
+            run(master[i]);
+            close(slave);
+            _exit(0);
+        }
+        started++;
+    }
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    while(running) {
+        pause();
+    }
+    for(i = 0; i < started; ++i) {
+        kill(child[i], SIGTERM);
+        waitpid(child[i], NULL, 0);
+    }
+    for(i = 0; i < boards; ++i) {
+        close(master[i]);
+    }
+    return started == boards ? 0 : 1;
+}
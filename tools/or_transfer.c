@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2014 Officine Robotiche
+ * Author: Raffaello Bonghi
+ * email:  raffaello.bonghi@officinerobotiche.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * Block transfer with a board (see or_bus/or_block.h): write a file in an
+ * area of the board or read an area in a file (-r), with the throughput and
+ * the use of the serial line. A write resumes from the offset verified of
+ * the board with -c.
+ * Build on the host:
+ *      gcc -Iincludes -O2 tools/or_transfer.c src/or_host/or_transfer.c \
+ *          src/or_host/or_transport.c src/or_bus/or_message.c \
+ *          src/or_bus/or_frame.c src/or_bus/or_registry.c -o or_transfer
+ * Usage, write and read 64 KiB with a simulated board (tools/or_simulator.c):
+ *      or_simulator -b 115200
+ *      or_transfer [-a area] [-w window] [-t timeout] [-c] /dev/pts/3@115200 image
+ *      or_transfer -r [-s size] /dev/pts/3@115200 dump
+ */
+
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "or_host/or_transport.h"
+#include "or_host/or_transfer.h"
+
+#if FRAME_BLOCK
+
+/******************************************************************************/
+/* Transfer                                                                   */
+/******************************************************************************/
+
+double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    transport_t link;
+    block_state_t state;
+    unsigned char area = 0, * data;
+    unsigned int window = 0;
+    uint32_t size = 0, offset = 0, first;
+    int timeout = 1000, option, result;
+    bool dump = false, resume = false;
+    const char* baud;
+    FILE* file;
+    double start, seconds;
+
+    while((option = getopt(argc, argv, "ra:w:t:s:c")) != -1) {
+        switch(option) {
+        case 'r':
+            dump = true;
+            break;
+        case 'a':
+            area = atoi(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        case 't':
+            timeout = atoi(optarg);
+            break;
+        case 's':
+            size = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            resume = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-r] [-a area] [-w window] [-t timeout] [-s size] [-c] device[@baud] file\n", argv[0]);
+            return 1;
+        }
+    }
+    if(optind + 2 != argc) {
+        fprintf(stderr, "Usage: %s [-r] [-a area] [-w window] [-t timeout] [-s size] [-c] device[@baud] file\n", argv[0]);
+        return 1;
+    }
+    if(orb_transport_open(&link, &transport_serial, argv[optind]) < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    orb_transport_negotiate(&link, link.ops->integrity, timeout, NULL);
+    if(orb_transfer_state(&link, area, timeout, &state) < 0) {
+        perror("state");
+        return 1;
+    }
+    if(dump) {
+        if(size == 0 || size > state.size) {
+            size = state.size;
+        }
+        data = malloc(size);
+    } else {
+        file = fopen(argv[optind + 1], "rb");
+        if(file == NULL) {
+            perror(argv[optind + 1]);
+            return 1;
+        }
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        rewind(file);
+        data = malloc(size);
+        if(data == NULL || fread(data, 1, size, file) != size) {
+            perror(argv[optind + 1]);
+            return 1;
+        }
+        fclose(file);
+        if(resume && state.offset <= size) {
+            offset = state.offset;
+        }
+    }
+    if(data == NULL) {
+        perror("data");
+        return 1;
+    }
+    first = offset;
+    start = now();
+    if(dump) {
+        result = orb_transfer_read(&link, area, data, size, &offset, window, timeout);
+    } else {
+        result = orb_transfer_write(&link, area, data, size, &offset, window, timeout);
+    }
+    seconds = now() - start;
+    if(result < 0) {
+        fprintf(stderr, "%s: %s at offset %u\n", dump ? "read" : "write", strerror(errno), (unsigned) offset);
+    }
+    printf("%u bytes from offset %u in %.3f s, %.1f KiB/s", (unsigned) (offset - first), (unsigned) first,
+            seconds, (offset - first) / seconds / 1024);
+    // 10 bits for each byte on the serial line
+    baud = strchr(argv[optind], '@');
+    if(baud != NULL) {
+        printf(", %.0f%% of line rate", 100.0 * (offset - first) * 10 / seconds / atol(baud + 1));
+    }
+    printf("\n");
+    if(dump && result == 0) {
+        file = fopen(argv[optind + 1], "wb");
+        if(file == NULL || fwrite(data, 1, size, file) != size) {
+            perror(argv[optind + 1]);
+            return 1;
+        }
+        fclose(file);
+    }
+    free(data);
+    orb_transport_close(&link);
+    return result < 0 ? 1 : 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+    fprintf(stderr, "%s: built without the block family (FRAME_BLOCK)\n", argv[0]);
+    return 1;
+}
+
+#endif